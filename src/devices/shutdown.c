@@ -5,9 +5,20 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "threads/io.h"
+#include "threads/memstat.h"
+#include "threads/shrinker.h"
 #include "threads/thread.h"
 #ifdef USERPROG
+#include "userprog/elfcache.h"
 #include "userprog/exception.h"
+#include "userprog/ioring.h"
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/ksm.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#include "vm/zswap.h"
+#endif
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
@@ -126,7 +137,18 @@ print_stats (void)
 #endif
   console_print_stats ();
   kbd_print_stats ();
+  shrinker_print_stats ();
+  memstat_print_stats ();
 #ifdef USERPROG
   exception_print_stats ();
+  ioring_print_stats ();
+  elf_cache_print_stats ();
+#endif
+#ifdef VM
+  page_print_stats ();
+  frame_print_stats ();
+  ksm_print_stats ();
+  swap_print_stats ();
+  zswap_print_stats ();
 #endif
 }
@@ -3,8 +3,11 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include <timepage.h>
 #include "devices/pit.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/alarm.h"
@@ -25,17 +28,33 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Time page, which user processes map read-only.  See
+   lib/timepage.h. */
+static struct timepage *time_page;
+
+/* Whether the CPU has a time stamp counter. */
+static bool have_tsc;
+
+/* Nanoseconds per timer tick. */
+#define NS_PER_TICK (1000 * 1000 * 1000 / TIMER_FREQ)
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
 static void real_time_delay (int64_t num, int32_t denom);
+static void update_time_page (void);
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
-   and registers the corresponding interrupt. */
+   and registers the corresponding interrupt.  Also allocates the
+   time page, so palloc_init() must already have been called. */
 void
 timer_init (void) 
 {
+  time_page = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+  time_page->freq = TIMER_FREQ;
+  have_tsc = cpu_has (CPUID_TSC);
+
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
@@ -77,6 +96,15 @@ timer_ticks (void)
   return t;
 }
 
+/* Returns the kernel virtual address of the time page, which
+   user processes map read-only to read the time without a
+   system call.  See lib/timepage.h. */
+void *
+timer_time_page (void)
+{
+  return time_page;
+}
+
 /* Returns the number of timer ticks elapsed since THEN, which
    should be a value once returned by timer_ticks(). */
 int64_t
@@ -174,10 +202,44 @@ static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
   ticks++;
+  update_time_page ();
   thread_tick ();
   alarm_check_sleeping_list ((uint64_t) ticks);
 }
 
+/* Stores the new tick count in the time page, along with the
+   time stamp counter and, from the TSC cycles between ticks, a
+   running average of the TSC's rate.  Readers retry if SEQ
+   changes or is odd, so the page must be consistent whenever SEQ
+   is even. */
+static void
+update_time_page (void)
+{
+  struct timepage *tp = time_page;
+  uint64_t tsc = have_tsc ? cpu_rdtsc () : 0;
+
+  tp->seq++;
+  barrier ();
+
+  tp->ticks = ticks;
+  if (have_tsc && tp->tsc != 0)
+    {
+      uint64_t cycles = tsc - tp->tsc;
+
+      /* A tick delayed by disabled interrupts looks long, so
+         weight each new measurement lightly. */
+      tp->tsc_per_tick = (tp->tsc_per_tick == 0
+                          ? cycles
+                          : (tp->tsc_per_tick * 7 + cycles) / 8);
+      if (tp->tsc_per_tick != 0)
+        tp->ns_mult = ((uint64_t) NS_PER_TICK << 32) / tp->tsc_per_tick;
+    }
+  tp->tsc = tsc;
+
+  barrier ();
+  tp->seq++;
+}
+
 /* Returns true if LOOPS iterations waits for more than one timer
    tick, otherwise false. */
 static bool
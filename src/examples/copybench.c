@@ -0,0 +1,205 @@
+/* copybench.c
+
+   Compares two ways to copy a file: a loop that reads into a
+   user buffer and writes it back out, as cp used to do, and
+   copy_file_range(), which copies inside the kernel.  Reports
+   cycles per kilobyte for each, for the read/write loop with
+   several buffer sizes, and checks that each copy is correct.
+
+   Usage: copybench [KB [ROUNDS]] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Default file size, in kB, and number of copies to time. */
+#define DEFAULT_KB 64
+#define DEFAULT_ROUNDS 4
+
+/* Scratch files. */
+#define IN_NAME "copybench.in"
+#define OUT_NAME "copybench.out"
+
+static char buf[4096];
+static char check[4096];
+
+/* Returns the CPU's time stamp counter. */
+static unsigned long long
+rdtsc (void)
+{
+  unsigned long long tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Prints an error message, removes the scratch files, and
+   exits. */
+static void
+fail (const char *msg)
+{
+  printf ("copybench: %s\n", msg);
+  remove (IN_NAME);
+  remove (OUT_NAME);
+  exit (EXIT_FAILURE);
+}
+
+/* Returns the number of bytes of BUF to use at offset OFS in a
+   SIZE-byte file. */
+static int
+chunk_size (int size, int ofs)
+{
+  return size - ofs < (int) sizeof buf ? size - ofs : (int) sizeof buf;
+}
+
+/* Opens the scratch files into *IN_FD and *OUT_FD. */
+static void
+open_files (int *in_fd, int *out_fd)
+{
+  *in_fd = open (IN_NAME);
+  *out_fd = open (OUT_NAME);
+  if (*in_fd < 0 || *out_fd < 0)
+    fail ("open failed");
+}
+
+/* Copies SIZE bytes with a read/write loop through a BUF_SIZE
+   byte buffer and returns the number of cycles taken. */
+static unsigned long long
+copy_loop (int size, int buf_size)
+{
+  unsigned long long start;
+  int in_fd, out_fd;
+  int left;
+
+  open_files (&in_fd, &out_fd);
+  start = rdtsc ();
+  for (left = size; left > 0; left -= buf_size)
+    {
+      int chunk = left < buf_size ? left : buf_size;
+      if (read (in_fd, buf, chunk) != chunk
+          || write (out_fd, buf, chunk) != chunk)
+        fail ("read/write copy failed");
+    }
+  start = rdtsc () - start;
+  close (in_fd);
+  close (out_fd);
+  return start;
+}
+
+/* Copies SIZE bytes with copy_file_range() and returns the
+   number of cycles taken. */
+static unsigned long long
+copy_kernel (int size)
+{
+  unsigned long long start;
+  int in_fd, out_fd;
+
+  open_files (&in_fd, &out_fd);
+  start = rdtsc ();
+  if (copy_file_range (in_fd, out_fd, size) != size)
+    fail ("copy_file_range failed");
+  start = rdtsc () - start;
+  close (in_fd);
+  close (out_fd);
+  return start;
+}
+
+/* Checks that the SIZE-byte output file matches the input. */
+static void
+verify (int size)
+{
+  int in_fd, out_fd;
+  int ofs;
+
+  open_files (&in_fd, &out_fd);
+  for (ofs = 0; ofs < size; ofs += sizeof buf)
+    {
+      int chunk = chunk_size (size, ofs);
+      if (read (in_fd, buf, chunk) != chunk
+          || read (out_fd, check, chunk) != chunk
+          || memcmp (buf, check, chunk))
+        fail ("copy does not match original");
+    }
+  close (in_fd);
+  close (out_fd);
+
+  /* Scribble over the copy, so that the next copy is checked
+     too. */
+  out_fd = open (OUT_NAME);
+  memset (buf, 0, sizeof buf);
+  for (ofs = 0; ofs < size; ofs += sizeof buf)
+    write (out_fd, buf, chunk_size (size, ofs));
+  close (out_fd);
+}
+
+/* Prints the cost per kB of TEST, which took CYCLES to copy
+   SIZE bytes ROUNDS times. */
+static void
+report (const char *test, unsigned long long cycles, int size, int rounds)
+{
+  printf ("%s: %llu cycles per kB\n",
+          test, cycles / ((unsigned long long) rounds * (size / 1024)));
+}
+
+int
+main (int argc, char *argv[])
+{
+  static const int buf_sizes[] = {512, 1024, 4096};
+  int kb = DEFAULT_KB;
+  int rounds = DEFAULT_ROUNDS;
+  unsigned long long cycles;
+  int size, fd, ofs, i, r;
+
+  if (argc > 1)
+    kb = atoi (argv[1]);
+  if (argc > 2)
+    rounds = atoi (argv[2]);
+  if (kb < 1 || rounds < 1)
+    {
+      printf ("usage: copybench [KB [ROUNDS]]\n");
+      return EXIT_FAILURE;
+    }
+  size = kb * 1024;
+
+  /* Make the input file, with contents that differ from sector
+     to sector, and an empty output file of the same size. */
+  if (!create (IN_NAME, size) || !create (OUT_NAME, size))
+    fail ("create failed");
+  fd = open (IN_NAME);
+  if (fd < 0)
+    fail ("open failed");
+  for (ofs = 0; ofs < size; ofs += sizeof buf)
+    {
+      int chunk = chunk_size (size, ofs);
+      for (i = 0; i < chunk; i++)
+        buf[i] = (ofs + i) / 512 + i;
+      write (fd, buf, chunk);
+    }
+  close (fd);
+
+  for (i = 0; i < (int) (sizeof buf_sizes / sizeof *buf_sizes); i++)
+    {
+      char test[64];
+
+      cycles = 0;
+      for (r = 0; r < rounds; r++)
+        {
+          cycles += copy_loop (size, buf_sizes[i]);
+          verify (size);
+        }
+      snprintf (test, sizeof test, "read/write, %d-byte buffer", buf_sizes[i]);
+      report (test, cycles, size, rounds);
+    }
+
+  cycles = 0;
+  for (r = 0; r < rounds; r++)
+    {
+      cycles += copy_kernel (size);
+      verify (size);
+    }
+  report ("copy_file_range", cycles, size, rounds);
+
+  remove (IN_NAME);
+  remove (OUT_NAME);
+  return EXIT_SUCCESS;
+}
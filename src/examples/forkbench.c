@@ -0,0 +1,93 @@
+/* forkbench.c
+
+   Compares the latency of creating a process with fork() against
+   exec() of the same program.  Each round starts one child that
+   exits at once and waits for it.
+
+   Usage: forkbench [ROUNDS] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Default number of processes to create with each method. */
+#define DEFAULT_ROUNDS 32
+
+/* Returns the CPU's time stamp counter. */
+static unsigned long long
+rdtsc (void)
+{
+  unsigned long long tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Creates ROUNDS children with fork() and returns the number of
+   cycles taken, or 0 if fork() fails. */
+static unsigned long long
+time_fork (int rounds)
+{
+  unsigned long long start = rdtsc ();
+  int i;
+
+  for (i = 0; i < rounds; i++)
+    {
+      pid_t pid = fork ();
+      if (pid == 0)
+        exit (0);
+      else if (pid == PID_ERROR)
+        return 0;
+      wait (pid);
+    }
+  return rdtsc () - start;
+}
+
+/* Creates ROUNDS children with exec() and returns the number of
+   cycles taken, or 0 if exec() fails. */
+static unsigned long long
+time_exec (int rounds)
+{
+  unsigned long long start = rdtsc ();
+  int i;
+
+  for (i = 0; i < rounds; i++)
+    {
+      pid_t pid = exec ("forkbench -child");
+      if (pid == PID_ERROR)
+        return 0;
+      wait (pid);
+    }
+  return rdtsc () - start;
+}
+
+/* Prints the per-process latency of METHOD, which took CYCLES
+   for ROUNDS processes. */
+static void
+report (const char *method, unsigned long long cycles, int rounds)
+{
+  if (cycles == 0)
+    printf ("%s: failed\n", method);
+  else
+    printf ("%s: %llu cycles per process\n", method, cycles / rounds);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int rounds = DEFAULT_ROUNDS;
+
+  if (argc > 1 && !strcmp (argv[1], "-child"))
+    return EXIT_SUCCESS;
+  if (argc > 1)
+    rounds = atoi (argv[1]);
+  if (rounds < 1)
+    {
+      printf ("usage: forkbench [ROUNDS]\n");
+      return EXIT_FAILURE;
+    }
+
+  report ("fork", time_fork (rounds), rounds);
+  report ("exec", time_exec (rounds), rounds);
+  return EXIT_SUCCESS;
+}
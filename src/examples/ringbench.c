@@ -0,0 +1,188 @@
+/* ringbench.c
+
+   Compares plain system calls with submission and completion
+   rings for I/O on many small files.  Each round opens every
+   file, reads (or writes) it, and closes it again: with plain
+   system calls, that takes three calls per file; with rings, it
+   takes one ioring_enter() call per step for all of the files.
+
+   Usage: ringbench [FILES [ROUNDS]] */
+
+#include <ioring.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+/* Default number of files and of rounds. */
+#define DEFAULT_FILES 32
+#define DEFAULT_ROUNDS 10
+
+/* Most files.  Each step submits one operation per file, so they
+   must all fit in the submission ring at once. */
+#define MAX_FILES IORING_SQ_ENTRIES
+
+/* Size of each file, in bytes. */
+#define FILE_SIZE 512
+
+/* Address at which to map the rings. */
+#define RING_ADDR ((void *) 0x10000000)
+
+static char names[MAX_FILES][16];
+static char bufs[MAX_FILES][FILE_SIZE];
+static int fds[MAX_FILES];
+static struct ioring *ring;
+
+/* Returns the CPU's time stamp counter. */
+static unsigned long long
+rdtsc (void)
+{
+  unsigned long long tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Prints an error message and exits. */
+static void
+fail (const char *msg)
+{
+  printf ("ringbench: %s\n", msg);
+  exit (EXIT_FAILURE);
+}
+
+/* Queues an operation in the submission ring, with its index I
+   as user data. */
+static void
+queue (uint8_t op, int fd, void *addr, unsigned len, int i)
+{
+  struct ioring_sqe *sqe = &ring->sqes[ring->sq_tail % IORING_SQ_ENTRIES];
+
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->addr = addr;
+  sqe->len = len;
+  sqe->ofs = 0;
+  sqe->user_data = i;
+  ring->sq_tail++;
+}
+
+/* Submits the CNT queued operations, waits for all of them, and
+   stores each one's result in RESULTS[] at its index. */
+static void
+run (int cnt, int results[])
+{
+  if (ioring_enter (cnt, cnt) != cnt)
+    fail ("ioring_enter failed");
+  while (ring->cq_head != ring->cq_tail)
+    {
+      struct ioring_cqe *cqe = &ring->cqes[ring->cq_head % IORING_CQ_ENTRIES];
+      results[cqe->user_data] = cqe->res;
+      ring->cq_head++;
+    }
+}
+
+/* Opens, reads or writes, and closes each of CNT files with
+   plain system calls. */
+static void
+plain_round (int cnt, bool writing)
+{
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      int fd = open (names[i]);
+      int bytes;
+
+      if (fd < 0)
+        fail ("open failed");
+      bytes = (writing
+               ? write (fd, bufs[i], FILE_SIZE)
+               : read (fd, bufs[i], FILE_SIZE));
+      if (bytes != FILE_SIZE)
+        fail ("read or write failed");
+      close (fd);
+    }
+}
+
+/* Opens, reads or writes, and closes each of CNT files with one
+   batch of ring operations per step. */
+static void
+ring_round (int cnt, bool writing)
+{
+  int results[MAX_FILES];
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    queue (IORING_OP_OPEN, 0, names[i], 0, i);
+  run (cnt, fds);
+  for (i = 0; i < cnt; i++)
+    {
+      if (fds[i] < 0)
+        fail ("ring open failed");
+      queue (writing ? IORING_OP_WRITE : IORING_OP_READ,
+             fds[i], bufs[i], FILE_SIZE, i);
+    }
+  run (cnt, results);
+  for (i = 0; i < cnt; i++)
+    {
+      if (results[i] != FILE_SIZE)
+        fail ("ring read or write failed");
+      queue (IORING_OP_CLOSE, fds[i], NULL, 0, i);
+    }
+  run (cnt, results);
+}
+
+/* Runs ROUNDS rounds of ROUND on CNT files and prints the time
+   per file. */
+static void
+report (const char *test, void (*round) (int, bool), int cnt, bool writing,
+        int rounds)
+{
+  unsigned long long start = rdtsc ();
+  int i;
+
+  for (i = 0; i < rounds; i++)
+    round (cnt, writing);
+  printf ("%s: %llu cycles per file\n",
+          test, (rdtsc () - start) / ((unsigned long long) rounds * cnt));
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cnt = DEFAULT_FILES;
+  int rounds = DEFAULT_ROUNDS;
+  int i;
+
+  if (argc > 1)
+    cnt = atoi (argv[1]);
+  if (argc > 2)
+    rounds = atoi (argv[2]);
+  if (cnt < 1 || cnt > MAX_FILES || rounds < 1)
+    {
+      printf ("usage: ringbench [FILES [ROUNDS]], with at most %d files\n",
+              MAX_FILES);
+      return EXIT_FAILURE;
+    }
+
+  ring = ioring_setup (RING_ADDR);
+  if (ring == NULL)
+    fail ("ioring_setup failed");
+
+  for (i = 0; i < cnt; i++)
+    {
+      snprintf (names[i], sizeof names[i], "ring%d.tmp", i);
+      memset (bufs[i], 'a' + i % 26, FILE_SIZE);
+      if (!create (names[i], FILE_SIZE))
+        fail ("create failed");
+    }
+
+  report ("write (plain)", plain_round, cnt, true, rounds);
+  report ("write (ring)", ring_round, cnt, true, rounds);
+  report ("read (plain)", plain_round, cnt, false, rounds);
+  report ("read (ring)", ring_round, cnt, false, rounds);
+
+  for (i = 0; i < cnt; i++)
+    remove (names[i]);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/* syscallbench.c
+
+   Measures the round-trip latency of system calls: tell() on an
+   open file, which does almost nothing in the kernel, and
+   read() of 1 and 512 bytes, which also copy to user memory.
+   The tell() latency is reported for entry through "int $0x30"
+   and, if the CPU supports it, through SYSENTER.  For
+   comparison, it also measures gettime_ns(), which reads the
+   time from a shared page without entering the kernel.
+
+   Usage: syscallbench [ROUNDS] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include <time.h>
+
+/* Default number of calls to time for each test. */
+#define DEFAULT_ROUNDS 10000
+
+/* Scratch file. */
+#define FILE_NAME "syscallbench.tmp"
+
+static char buf[512];
+
+/* Returns the CPU's time stamp counter. */
+static unsigned long long
+rdtsc (void)
+{
+  unsigned long long tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Calls tell() on FD ROUNDS times and returns the number of
+   cycles taken. */
+static unsigned long long
+time_tell (int fd, int rounds)
+{
+  unsigned long long start = rdtsc ();
+  int i;
+
+  for (i = 0; i < rounds; i++)
+    tell (fd);
+  return rdtsc () - start;
+}
+
+/* Calls gettime_ns() ROUNDS times and returns the number of
+   cycles taken. */
+static unsigned long long
+time_gettime (int rounds)
+{
+  unsigned long long start = rdtsc ();
+  int i;
+
+  for (i = 0; i < rounds; i++)
+    gettime_ns ();
+  return rdtsc () - start;
+}
+
+/* Reads SIZE bytes from the start of FD ROUNDS times and returns
+   the number of cycles taken, less those taken by seeking. */
+static unsigned long long
+time_read (int fd, int size, int rounds)
+{
+  unsigned long long seek_cycles = 0;
+  unsigned long long start = rdtsc ();
+  int i;
+
+  for (i = 0; i < rounds; i++)
+    {
+      unsigned long long seek_start = rdtsc ();
+      seek (fd, 0);
+      seek_cycles += rdtsc () - seek_start;
+      read (fd, buf, size);
+    }
+  return rdtsc () - start - seek_cycles;
+}
+
+/* Prints the per-call latency of TEST, which took CYCLES for
+   ROUNDS calls. */
+static void
+report (const char *test, unsigned long long cycles, int rounds)
+{
+  printf ("%s: %llu cycles per call\n", test, cycles / rounds);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int rounds = DEFAULT_ROUNDS;
+  int fd;
+
+  if (argc > 1)
+    rounds = atoi (argv[1]);
+  if (rounds < 1)
+    {
+      printf ("usage: syscallbench [ROUNDS]\n");
+      return EXIT_FAILURE;
+    }
+
+  if (!create (FILE_NAME, sizeof buf))
+    {
+      printf ("syscallbench: create %s failed\n", FILE_NAME);
+      return EXIT_FAILURE;
+    }
+  fd = open (FILE_NAME);
+  if (fd < 0)
+    {
+      printf ("syscallbench: open %s failed\n", FILE_NAME);
+      remove (FILE_NAME);
+      return EXIT_FAILURE;
+    }
+
+  if (syscall_sysenter)
+    {
+      report ("tell (sysenter)", time_tell (fd, rounds), rounds);
+      syscall_sysenter = false;
+      report ("tell (int $0x30)", time_tell (fd, rounds), rounds);
+      syscall_sysenter = true;
+    }
+  else
+    report ("tell (int $0x30)", time_tell (fd, rounds), rounds);
+  report ("gettime_ns (no trap)", time_gettime (rounds), rounds);
+  report ("read 1 byte", time_read (fd, 1, rounds), rounds);
+  report ("read 512 bytes", time_read (fd, sizeof buf, rounds), rounds);
+
+  close (fd);
+  remove (FILE_NAME);
+  return EXIT_SUCCESS;
+}
@@ -9,6 +9,7 @@ struct file
     struct inode *inode;        /* File's inode. */
     off_t pos;                  /* Current position. */
     bool deny_write;            /* Has file_deny_write() been called? */
+    int ref_cnt;                /* References from file_open(), file_dup(). */
   };
 
 /* Opens a file for the given INODE, of which it takes ownership,
@@ -23,6 +24,7 @@ file_open (struct inode *inode)
       file->inode = inode;
       file->pos = 0;
       file->deny_write = false;
+      file->ref_cnt = 1;
       return file;
     }
   else
@@ -41,11 +43,23 @@ file_reopen (struct file *file)
   return file_open (inode_reopen (file->inode));
 }
 
-/* Closes FILE. */
+/* Returns a new reference to FILE, which shares its position
+   and everything else with FILE.  Each reference must be closed
+   with file_close(). */
+struct file *
+file_dup (struct file *file)
+{
+  ASSERT (file->ref_cnt > 0);
+  file->ref_cnt++;
+  return file;
+}
+
+/* Closes a reference to FILE, and closes FILE itself if it was
+   the last one. */
 void
 file_close (struct file *file) 
 {
-  if (file != NULL)
+  if (file != NULL && --file->ref_cnt == 0)
     {
       file_allow_write (file);
       inode_close (file->inode);
@@ -84,6 +98,20 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs)
   return inode_read_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Reads from FILE into the IOV_CNT buffers in IOV, in order,
+   starting at the file's current position, as a single
+   operation.  Returns the number of bytes actually read, which
+   may be less than the buffers' total length if end of file is
+   reached.  Advances FILE's position by the number of bytes
+   read. */
+off_t
+file_readv (struct file *file, const struct iovec *iov, int iov_cnt)
+{
+  off_t bytes_read = inode_readv_at (file->inode, iov, iov_cnt, file->pos);
+  file->pos += bytes_read;
+  return bytes_read;
+}
+
 /* Writes SIZE bytes from BUFFER into FILE,
    starting at the file's current position.
    Returns the number of bytes actually written,
@@ -113,6 +141,71 @@ file_write_at (struct file *file, const void *buffer, off_t size,
   return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Writes the IOV_CNT buffers in IOV, in order, into FILE,
+   starting at the file's current position, as a single
+   operation.  Returns the number of bytes actually written,
+   which may be less than the buffers' total length if end of
+   file is reached.  Advances FILE's position by the number of
+   bytes written. */
+off_t
+file_writev (struct file *file, const struct iovec *iov, int iov_cnt)
+{
+  off_t bytes_written = inode_writev_at (file->inode, iov, iov_cnt,
+                                         file->pos);
+  file->pos += bytes_written;
+  return bytes_written;
+}
+
+/* Reads from FILE into the IOV_CNT buffers in IOV, in order,
+   starting at offset FILE_OFS in the file.  Returns the number
+   of bytes actually read, which may be less than the buffers'
+   total size if end of file is reached.  The file's current
+   position is unaffected. */
+off_t
+file_readv_at (struct file *file, const struct iovec *iov, int iov_cnt,
+               off_t file_ofs)
+{
+  return inode_readv_at (file->inode, iov, iov_cnt, file_ofs);
+}
+
+/* Writes the IOV_CNT buffers in IOV, in order, into FILE,
+   starting at offset FILE_OFS in the file.  Returns the number
+   of bytes actually written, which may be less than the
+   buffers' total size if end of file is reached.  The file's
+   current position is unaffected. */
+off_t
+file_writev_at (struct file *file, const struct iovec *iov, int iov_cnt,
+                off_t file_ofs)
+{
+  return inode_writev_at (file->inode, iov, iov_cnt, file_ofs);
+}
+
+/* Copies up to SIZE bytes from IN, starting at its current
+   position, to OUT, starting at its current position, inside
+   the kernel, and advances both positions by the number of
+   bytes copied.  Returns the number of bytes copied, which may
+   be less than SIZE if end of either file is reached, or -1,
+   copying nothing, if IN and OUT are the same file and the two
+   ranges overlap. */
+off_t
+file_copy (struct file *out, struct file *in, off_t size)
+{
+  off_t in_left = inode_length (in->inode) - in->pos;
+  off_t bytes_copied;
+
+  if (size > in_left)
+    size = in_left > 0 ? in_left : 0;
+  if (in->inode == out->inode
+      && in->pos - out->pos < size && out->pos - in->pos < size)
+    return -1;
+
+  bytes_copied = inode_copy_range (out->inode, out->pos,
+                                   in->inode, in->pos, size);
+  in->pos += bytes_copied;
+  out->pos += bytes_copied;
+  return bytes_copied;
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void
@@ -6,6 +6,9 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#ifdef VM
+#include "vm/frame.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -36,6 +39,7 @@ struct inode
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+    unsigned version;                   /* Changes when contents change. */
     struct inode_disk data;             /* Inode content. */
   };
 
@@ -137,6 +141,7 @@ inode_open (block_sector_t sector)
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
   inode->removed = false;
+  inode->version = 0;
   block_read (fs_device, inode->sector, &inode->data);
   return inode;
 }
@@ -192,18 +197,112 @@ inode_remove (struct inode *inode)
 {
   ASSERT (inode != NULL);
   inode->removed = true;
+  inode->version++;
+}
+
+/* A position within an I/O vector. */
+struct iov_iter
+  {
+    const struct iovec *iov;            /* Current buffer. */
+    int cnt;                            /* Buffers left, including IOV. */
+    size_t ofs;                         /* Offset within IOV. */
+  };
+
+/* Initializes ITER to the start of the CNT buffers in IOV. */
+static void
+iov_iter_init (struct iov_iter *iter, const struct iovec *iov, int cnt)
+{
+  iter->iov = iov;
+  iter->cnt = cnt;
+  iter->ofs = 0;
+}
+
+/* Returns the number of bytes left in the current buffer of
+   ITER, skipping over empty buffers. */
+static size_t
+iov_iter_left (struct iov_iter *iter)
+{
+  while (iter->cnt > 0 && iter->ofs >= iter->iov->iov_len)
+    {
+      iter->iov++;
+      iter->cnt--;
+      iter->ofs = 0;
+    }
+  return iter->cnt > 0 ? iter->iov->iov_len - iter->ofs : 0;
+}
+
+/* Returns ITER's current position as a pointer and advances it
+   by SIZE bytes, which must not exceed iov_iter_left(). */
+static uint8_t *
+iov_iter_advance (struct iov_iter *iter, size_t size)
+{
+  uint8_t *p = (uint8_t *) iter->iov->iov_base + iter->ofs;
+  iter->ofs += size;
+  return p;
+}
+
+/* Copies SIZE bytes from BUF to the buffers at ITER, or from
+   them to BUF if TO_ITER is false, advancing ITER. */
+static void
+iov_iter_copy (struct iov_iter *iter, uint8_t *buf, size_t size,
+               bool to_iter)
+{
+  while (size > 0)
+    {
+      size_t left = iov_iter_left (iter);
+      size_t n = size < left ? size : left;
+      uint8_t *p = iov_iter_advance (iter, n);
+
+      if (to_iter)
+        memcpy (p, buf, n);
+      else
+        memcpy (buf, p, n);
+      buf += n;
+      size -= n;
+    }
+}
+
+/* Returns the total length of the CNT buffers in IOV. */
+static off_t
+iov_length (const struct iovec *iov, int cnt)
+{
+  off_t length = 0;
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    length += iov[i].iov_len;
+  return length;
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
    Returns the number of bytes actually read, which may be less
    than SIZE if an error occurs or end of file is reached. */
 off_t
-inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) 
+inode_read_at (struct inode *inode, void *buffer, off_t size, off_t offset) 
 {
-  uint8_t *buffer = buffer_;
+  struct iovec iov;
+
+  iov.iov_base = buffer;
+  iov.iov_len = size;
+  return inode_readv_at (inode, &iov, 1, offset);
+}
+
+/* Reads from INODE into the IOV_CNT buffers in IOV, in order,
+   starting at position OFFSET.  Each sector is read once, even
+   if it is scattered across several buffers.  Returns the
+   number of bytes actually read, which may be less than the
+   buffers' total length if an error occurs or end of file is
+   reached. */
+off_t
+inode_readv_at (struct inode *inode, const struct iovec *iov, int iov_cnt,
+                off_t offset)
+{
+  struct iov_iter iter;
+  off_t size = iov_length (iov, iov_cnt);
   off_t bytes_read = 0;
   uint8_t *bounce = NULL;
 
+  iov_iter_init (&iter, iov, iov_cnt);
   while (size > 0) 
     {
       /* Disk sector to read, starting byte offset within sector. */
@@ -220,15 +319,17 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
       if (chunk_size <= 0)
         break;
 
-      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
+      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE
+          && iov_iter_left (&iter) >= BLOCK_SECTOR_SIZE)
         {
           /* Read full sector directly into caller's buffer. */
-          block_read (fs_device, sector_idx, buffer + bytes_read);
+          block_read (fs_device, sector_idx,
+                      iov_iter_advance (&iter, BLOCK_SECTOR_SIZE));
         }
       else 
         {
           /* Read sector into bounce buffer, then partially copy
-             into caller's buffer. */
+             into caller's buffers. */
           if (bounce == NULL) 
             {
               bounce = malloc (BLOCK_SECTOR_SIZE);
@@ -236,7 +337,7 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
                 break;
             }
           block_read (fs_device, sector_idx, bounce);
-          memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
+          iov_iter_copy (&iter, bounce + sector_ofs, chunk_size, true);
         }
       
       /* Advance. */
@@ -255,16 +356,35 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
    (Normally a write at end of file would extend the inode, but
    growth is not yet implemented.) */
 off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
                 off_t offset) 
 {
-  const uint8_t *buffer = buffer_;
+  struct iovec iov;
+
+  iov.iov_base = (void *) buffer;
+  iov.iov_len = size;
+  return inode_writev_at (inode, &iov, 1, offset);
+}
+
+/* Writes the IOV_CNT buffers in IOV, in order, into INODE,
+   starting at OFFSET.  Each sector is written once, even if it
+   is gathered from several buffers.  Returns the number of bytes
+   actually written, which may be less than the buffers' total
+   length if end of file is reached or an error occurs. */
+off_t
+inode_writev_at (struct inode *inode, const struct iovec *iov, int iov_cnt,
+                 off_t offset)
+{
+  struct iov_iter iter;
+  off_t size = iov_length (iov, iov_cnt);
   off_t bytes_written = 0;
   uint8_t *bounce = NULL;
 
   if (inode->deny_write_cnt)
     return 0;
+  inode->version++;
 
+  iov_iter_init (&iter, iov, iov_cnt);
   while (size > 0) 
     {
       /* Sector to write, starting byte offset within sector. */
@@ -281,10 +401,12 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
       if (chunk_size <= 0)
         break;
 
-      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE)
+      if (sector_ofs == 0 && chunk_size == BLOCK_SECTOR_SIZE
+          && iov_iter_left (&iter) >= BLOCK_SECTOR_SIZE)
         {
           /* Write full sector directly to disk. */
-          block_write (fs_device, sector_idx, buffer + bytes_written);
+          block_write (fs_device, sector_idx,
+                       iov_iter_advance (&iter, BLOCK_SECTOR_SIZE));
         }
       else 
         {
@@ -303,7 +425,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
             block_read (fs_device, sector_idx, bounce);
           else
             memset (bounce, 0, BLOCK_SECTOR_SIZE);
-          memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
+          iov_iter_copy (&iter, bounce + sector_ofs, chunk_size, false);
           block_write (fs_device, sector_idx, bounce);
         }
 
@@ -314,9 +436,91 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
     }
   free (bounce);
 
+#ifdef VM
+  /* Update the pages of INODE that processes have mapped. */
+  offset -= bytes_written;
+  for (size = bytes_written; size > 0; iov++)
+    {
+      off_t len = (off_t) iov->iov_len < size ? (off_t) iov->iov_len : size;
+      frame_write_file (inode, offset, iov->iov_base, len);
+      offset += len;
+      size -= len;
+    }
+#endif
+
   return bytes_written;
 }
 
+/* Copies SIZE bytes from IN, starting at position IN_OFS, to
+   OUT, starting at OUT_OFS, without passing through the
+   caller's memory.  Returns the number of bytes actually copied,
+   which may be less than SIZE if end of either file is reached
+   or an error occurs.  IN and OUT may be the same inode only if
+   the two ranges do not overlap.
+
+   When the two offsets are at the same place within a sector,
+   each whole sector is moved with one block_read() and one
+   block_write() through a single sector buffer, with no bounce
+   copies.  Partial sectors, and all of the sectors when the
+   offsets are misaligned, go through inode_read_at() and
+   inode_write_at().  Either way, the pages of OUT that processes
+   have mapped are updated as for inode_writev_at(). */
+off_t
+inode_copy_range (struct inode *out, off_t out_ofs,
+                  struct inode *in, off_t in_ofs, off_t size)
+{
+  off_t bytes_copied = 0;
+  uint8_t *buffer;
+
+  if (out->deny_write_cnt)
+    return 0;
+  out->version++;
+
+  buffer = malloc (BLOCK_SECTOR_SIZE);
+  if (buffer == NULL)
+    return 0;
+  while (size > 0)
+    {
+      /* Bytes left in either inode, bytes left in the output
+         sector, least of these. */
+      off_t in_left = inode_length (in) - in_ofs;
+      off_t out_left = inode_length (out) - out_ofs;
+      int sector_left = BLOCK_SECTOR_SIZE - out_ofs % BLOCK_SECTOR_SIZE;
+      off_t min_left = in_left < out_left ? in_left : out_left;
+      int chunk_size;
+
+      if (sector_left < min_left)
+        min_left = sector_left;
+      chunk_size = size < min_left ? size : min_left;
+      if (chunk_size <= 0)
+        break;
+
+      if (chunk_size == BLOCK_SECTOR_SIZE && in_ofs % BLOCK_SECTOR_SIZE == 0)
+        {
+          /* Move a whole sector from disk to disk. */
+          block_read (fs_device, byte_to_sector (in, in_ofs), buffer);
+          block_write (fs_device, byte_to_sector (out, out_ofs), buffer);
+#ifdef VM
+          /* inode_writev_at() does this for the other case. */
+          frame_write_file (out, out_ofs, buffer, BLOCK_SECTOR_SIZE);
+#endif
+        }
+      else if (inode_read_at (in, buffer, chunk_size, in_ofs) != chunk_size
+               || inode_write_at (out, buffer, chunk_size, out_ofs)
+                  != chunk_size)
+        break;
+
+      /* Advance. */
+      size -= chunk_size;
+      in_ofs += chunk_size;
+      out_ofs += chunk_size;
+      bytes_copied += chunk_size;
+    }
+  free (buffer);
+
+  return bytes_copied;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
@@ -343,3 +547,12 @@ inode_length (const struct inode *inode)
 {
   return inode->data.length;
 }
+
+/* Returns INODE's version, which changes whenever INODE is
+   written or removed.  Lets a cache of data derived from INODE's
+   contents tell whether it is still current. */
+unsigned
+inode_version (const struct inode *inode)
+{
+  return inode->version;
+}
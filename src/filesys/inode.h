@@ -1,6 +1,7 @@
 #ifndef FILESYS_INODE_H
 #define FILESYS_INODE_H
 
+#include <iovec.h>
 #include <stdbool.h>
 #include "filesys/off_t.h"
 #include "devices/block.h"
@@ -16,8 +17,15 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_readv_at (struct inode *, const struct iovec *, int iov_cnt,
+                      off_t offset);
+off_t inode_writev_at (struct inode *, const struct iovec *, int iov_cnt,
+                       off_t offset);
+off_t inode_copy_range (struct inode *out, off_t out_ofs,
+                        struct inode *in, off_t in_ofs, off_t size);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
+unsigned inode_version (const struct inode *);
 
 #endif /* filesys/inode.h */
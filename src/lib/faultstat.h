@@ -0,0 +1,38 @@
+#ifndef __LIB_FAULTSTAT_H
+#define __LIB_FAULTSTAT_H
+
+/* Page fault statistics, as kept by the kernel and returned to
+   user programs by the faultstat() system call. */
+
+#include <stdint.h>
+
+/* Classes of page faults. */
+enum fault_class
+  {
+    FAULT_MINOR,                /* Page already in memory, just mapped. */
+    FAULT_ZERO,                 /* New zero-filled page. */
+    FAULT_FILE,                 /* Page read from a file. */
+    FAULT_SWAP,                 /* Page read from swap. */
+    FAULT_COW,                  /* Write to a copy-on-write page. */
+    FAULT_STACK,                /* Stack growth. */
+    FAULT_INVALID,              /* Bad access, not resolved. */
+    FAULT_CLASS_CNT             /* Number of classes. */
+  };
+
+/* Latency histogram.  Bucket 0 counts faults that took fewer
+   than 2**(FAULT_HIST_SHIFT + 1) CPU cycles, as measured by the
+   time stamp counter; bucket N, for 0 < N < FAULT_HIST_BUCKETS
+   - 1, those that took at least 2**(FAULT_HIST_SHIFT + N) but
+   fewer than twice as many; and the last bucket, all the rest. */
+#define FAULT_HIST_BUCKETS 24
+#define FAULT_HIST_SHIFT 8
+
+/* Page fault statistics. */
+struct fault_stats
+  {
+    uint64_t count[FAULT_CLASS_CNT];    /* Faults per class. */
+    uint64_t cycles[FAULT_CLASS_CNT];   /* Total cycles per class. */
+    uint64_t hist[FAULT_CLASS_CNT][FAULT_HIST_BUCKETS];
+  };
+
+#endif /* lib/faultstat.h */
@@ -0,0 +1,72 @@
+#ifndef __LIB_IORING_H
+#define __LIB_IORING_H
+
+/* Submission and completion rings for batched, asynchronous
+   file system operations, shared between a user process and the
+   kernel.
+
+   The process maps a ring with ioring_setup().  To submit
+   operations, it fills in entries of SQES at SQ_TAIL and
+   advances SQ_TAIL, then calls ioring_enter(), which consumes
+   the entries from SQ_HEAD up to SQ_TAIL and hands them to
+   kernel worker threads.  As each operation finishes, the kernel
+   fills in the entry of CQES at CQ_TAIL and advances CQ_TAIL.
+   The process reads completions from CQ_HEAD, advancing it as it
+   goes, without entering the kernel.
+
+   Indexes increase without bound; an entry's index into its
+   array is its ring index modulo the array size.  Operations
+   may complete in any order. */
+
+#include <stdint.h>
+
+/* Operations. */
+enum ioring_op
+  {
+    IORING_OP_NOP,              /* Do nothing. */
+    IORING_OP_READ,             /* read() or pread(). */
+    IORING_OP_WRITE,            /* write() or pwrite(). */
+    IORING_OP_OPEN,             /* open(). */
+    IORING_OP_CLOSE,            /* close(). */
+    IORING_OP_FSYNC             /* Flush a file to disk. */
+  };
+
+/* Submission queue entry. */
+struct ioring_sqe
+  {
+    uint8_t op;                 /* An IORING_OP_* value. */
+    int fd;                     /* File descriptor, except for open. */
+    void *addr;                 /* Buffer, or file name for open. */
+    uint32_t len;               /* Buffer size in bytes. */
+    int32_t ofs;                /* File offset, or -1 for current position. */
+    uint32_t user_data;         /* Returned in the completion. */
+  };
+
+/* Completion queue entry. */
+struct ioring_cqe
+  {
+    uint32_t user_data;         /* From the submission. */
+    int32_t res;                /* Result of the operation, -1 on error. */
+  };
+
+/* Ring sizes.  The completion ring is larger, so that the
+   submission ring can be refilled before all of the completions
+   have been read. */
+#define IORING_SQ_ENTRIES 64
+#define IORING_CQ_ENTRIES 128
+
+/* Largest buffer for a read or write operation. */
+#define IORING_MAX_LEN (60 * 1024)
+
+/* A pair of rings.  It occupies one page. */
+struct ioring
+  {
+    volatile uint32_t sq_head;  /* Advanced by the kernel. */
+    volatile uint32_t sq_tail;  /* Advanced by the process. */
+    volatile uint32_t cq_head;  /* Advanced by the process. */
+    volatile uint32_t cq_tail;  /* Advanced by the kernel. */
+    struct ioring_sqe sqes[IORING_SQ_ENTRIES];
+    struct ioring_cqe cqes[IORING_CQ_ENTRIES];
+  };
+
+#endif /* lib/ioring.h */
@@ -0,0 +1,19 @@
+#ifndef __LIB_IOVEC_H
+#define __LIB_IOVEC_H
+
+/* I/O vectors, for scatter/gather I/O with the readv() and
+   writev() system calls. */
+
+#include <stddef.h>
+
+/* One buffer in an I/O vector. */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Length of buffer in bytes. */
+  };
+
+/* Maximum number of buffers in an I/O vector. */
+#define IOV_MAX 16
+
+#endif /* lib/iovec.h */
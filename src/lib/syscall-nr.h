@@ -28,7 +28,20 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_FORK,                   /* Duplicate this process. */
+    SYS_MADVISE,                /* Advise on expected memory use. */
+    SYS_FAULTSTAT,              /* Obtain page fault statistics. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write several buffers to a file. */
+    SYS_PREAD,                  /* Read from a file at a given position. */
+    SYS_PWRITE,                 /* Write to a file at a given position. */
+    SYS_IORING_SETUP,           /* Map submission and completion rings. */
+    SYS_IORING_ENTER,           /* Submit operations and await results. */
+    SYS_COPY_FILE_RANGE,        /* Copy between files inside the kernel. */
+    SYS_SET_CLOEXEC             /* Choose whether exec() keeps an fd. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,38 @@
+#ifndef __LIB_TIMEPAGE_H
+#define __LIB_TIMEPAGE_H
+
+/* Time page.
+
+   The kernel maps one page read-only into every user process at
+   TIMEPAGE_ADDR and updates it on every timer interrupt, so that
+   a process can read the time without a system call.
+
+   The kernel makes SEQ odd while it updates the page and even
+   again afterward.  A reader that sees the same even value of
+   SEQ before and after reading the other members has read a
+   consistent set of them; otherwise, it must try again.
+
+   The time in nanoseconds since boot is
+   TICKS * (1,000,000,000 / FREQ), plus, if NS_MULT is nonzero,
+   the cycles elapsed since TSC, converted with
+   (cycles * NS_MULT) >> 32 and limited to one tick.  See
+   lib/user/time.c. */
+
+#include <stdint.h>
+
+/* User virtual address of the time page: the page just below
+   where user programs are linked. */
+#define TIMEPAGE_ADDR ((void *) 0x08047000)
+
+struct timepage
+  {
+    uint32_t seq;               /* Odd while being updated. */
+    uint32_t freq;              /* Timer ticks per second. */
+    int64_t ticks;              /* Timer ticks since boot. */
+    uint64_t tsc;               /* Time stamp counter at last tick. */
+    uint64_t tsc_per_tick;      /* Average TSC cycles per tick. */
+    uint64_t ns_mult;           /* (ns per tick << 32) / TSC_PER_TICK,
+                                   or 0 if the TSC is not usable. */
+  };
+
+#endif /* lib/timepage.h */
@@ -1,16 +1,30 @@
 #include <syscall.h>
 #include "../syscall-nr.h"
 
+/* If true, system calls enter the kernel through SYSENTER,
+   otherwise through "int $0x30".  Set by syscall_init(). */
+bool syscall_sysenter;
+
+/* Enters the kernel, with the system call number and arguments
+   already pushed on the stack.  With SYSENTER, the kernel
+   returns to local label 2 and the stack pointer passed in %ecx;
+   see sysenter_entry in userprog/sysenter.S.  Either way, %ecx
+   and %edx are clobbered. */
+#define SYSCALL_TRAP                                            \
+        "cmpb $0, syscall_sysenter; je 1f; "                    \
+        "movl %%esp, %%ecx; movl $2f, %%edx; sysenter; "        \
+        "1: int $0x30; 2: "
+
 /* Invokes syscall NUMBER, passing no arguments, and returns the
    return value as an `int'. */
 #define syscall0(NUMBER)                                        \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
-            ("pushl %[number]; int $0x30; addl $4, %%esp"       \
+            ("pushl %[number]; " SYSCALL_TRAP "; addl $4, %%esp" \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER)                          \
-               : "memory");                                     \
+               : "ecx", "edx", "cc", "memory");                 \
           retval;                                               \
         })
 
@@ -20,11 +34,12 @@
         ({                                                               \
           int retval;                                                    \
           asm volatile                                                   \
-            ("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp" \
+            ("pushl %[arg0]; pushl %[number]; " SYSCALL_TRAP             \
+             "; addl $8, %%esp"                                          \
                : "=a" (retval)                                           \
                : [number] "i" (NUMBER),                                  \
                  [arg0] "g" (ARG0)                                       \
-               : "memory");                                              \
+               : "ecx", "edx", "cc", "memory");                          \
           retval;                                                        \
         })
 
@@ -35,12 +50,12 @@
           int retval;                                           \
           asm volatile                                          \
             ("pushl %[arg1]; pushl %[arg0]; "                   \
-             "pushl %[number]; int $0x30; addl $12, %%esp"      \
+             "pushl %[number]; " SYSCALL_TRAP "; addl $12, %%esp" \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER),                         \
                  [arg0] "g" (ARG0),                             \
                  [arg1] "g" (ARG1)                              \
-               : "memory");                                     \
+               : "ecx", "edx", "cc", "memory");                 \
           retval;                                               \
         })
 
@@ -51,16 +66,47 @@
           int retval;                                           \
           asm volatile                                          \
             ("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "    \
-             "pushl %[number]; int $0x30; addl $16, %%esp"      \
+             "pushl %[number]; " SYSCALL_TRAP "; addl $16, %%esp" \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER),                         \
                  [arg0] "g" (ARG0),                             \
                  [arg1] "g" (ARG1),                             \
                  [arg2] "g" (ARG2)                              \
-               : "memory");                                     \
+               : "ecx", "edx", "cc", "memory");                 \
           retval;                                               \
         })
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; "    \
+             "pushl %[arg0]; pushl %[number]; " SYSCALL_TRAP    \
+             "; addl $20, %%esp"                                \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "g" (ARG0),                             \
+                 [arg1] "g" (ARG1),                             \
+                 [arg2] "g" (ARG2),                             \
+                 [arg3] "g" (ARG3)                              \
+               : "ecx", "edx", "cc", "memory");                 \
+          retval;                                               \
+        })
+
+/* Uses SYSENTER for system calls if the CPU supports it.  The
+   kernel sets up SYSENTER whenever it does.  See [IA32-v2a]
+   "CPUID". */
+void
+syscall_init (void)
+{
+  unsigned eax = 1, ebx, ecx = 0, edx;
+
+  asm ("cpuid" : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+  syscall_sysenter = (edx & (1u << 11)) != 0 && (edx & (1u << 5)) != 0;
+}
+
 void
 halt (void) 
 {
@@ -182,3 +228,69 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+pid_t
+fork (void)
+{
+  return syscall0 (SYS_FORK);
+}
+
+bool
+madvise (void *addr, size_t length, int advice)
+{
+  return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+bool
+faultstat (bool self, struct fault_stats *stats)
+{
+  return syscall2 (SYS_FAULTSTAT, self, stats);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iov_cnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iov_cnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iov_cnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iov_cnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned position)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, position);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned position)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, position);
+}
+
+struct ioring *
+ioring_setup (void *addr)
+{
+  return (struct ioring *) syscall1 (SYS_IORING_SETUP, addr);
+}
+
+int
+ioring_enter (unsigned to_submit, unsigned min_complete)
+{
+  return syscall2 (SYS_IORING_ENTER, to_submit, min_complete);
+}
+
+int
+copy_file_range (int in_fd, int out_fd, unsigned size)
+{
+  return syscall3 (SYS_COPY_FILE_RANGE, in_fd, out_fd, size);
+}
+
+bool
+set_cloexec (int fd, bool cloexec)
+{
+  return syscall2 (SYS_SET_CLOEXEC, fd, cloexec);
+}
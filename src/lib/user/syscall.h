@@ -2,7 +2,11 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <debug.h>
+#include <faultstat.h>
+#include <ioring.h>
+#include <iovec.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -12,6 +16,13 @@ typedef int pid_t;
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
 
+/* Expected memory access patterns for madvise(). */
+#define MADV_NORMAL 0           /* No particular pattern. */
+#define MADV_SEQUENTIAL 1       /* Ascending order, once each. */
+#define MADV_RANDOM 2           /* No predictable order. */
+#define MADV_WILLNEED 3         /* Read in now. */
+#define MADV_DONTNEED 4         /* Discard contents. */
+
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
@@ -45,4 +56,19 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+extern bool syscall_sysenter;
+void syscall_init (void);
+pid_t fork (void);
+bool madvise (void *addr, size_t length, int advice);
+bool faultstat (bool self, struct fault_stats *);
+int readv (int fd, const struct iovec *, int iov_cnt);
+int writev (int fd, const struct iovec *, int iov_cnt);
+int pread (int fd, void *buffer, unsigned length, unsigned position);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned position);
+struct ioring *ioring_setup (void *addr);
+int ioring_enter (unsigned to_submit, unsigned min_complete);
+int copy_file_range (int in_fd, int out_fd, unsigned length);
+bool set_cloexec (int fd, bool cloexec);
+
 #endif /* lib/user/syscall.h */
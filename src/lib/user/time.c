@@ -0,0 +1,65 @@
+#include <time.h>
+#include <timepage.h>
+
+/* The time page, which the kernel maps read-only into every
+   process and updates on every timer interrupt. */
+static const volatile struct timepage *const time_page = TIMEPAGE_ADDR;
+
+/* Returns the CPU's time stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Returns the number of timer ticks since the OS booted. */
+int64_t
+gettime_ticks (void)
+{
+  uint32_t seq;
+  int64_t ticks;
+
+  do
+    {
+      seq = time_page->seq;
+      ticks = time_page->ticks;
+    }
+  while ((seq & 1) != 0 || time_page->seq != seq);
+  return ticks;
+}
+
+/* Returns the number of timer ticks per second. */
+unsigned
+gettime_freq (void)
+{
+  return time_page->freq;
+}
+
+/* Returns the number of nanoseconds since the OS booted.  The
+   resolution is one timer tick, unless the CPU has a time stamp
+   counter, in which case it is finer. */
+uint64_t
+gettime_ns (void)
+{
+  uint32_t seq;
+  uint64_t ns;
+
+  do
+    {
+      seq = time_page->seq;
+      ns = time_page->ticks * (1000000000u / time_page->freq);
+      if (time_page->ns_mult != 0)
+        {
+          /* Never count past the next tick, so that the time
+             does not jump backward when it arrives. */
+          uint64_t cycles = rdtsc () - time_page->tsc;
+          if (cycles > time_page->tsc_per_tick)
+            cycles = time_page->tsc_per_tick;
+          ns += (cycles * time_page->ns_mult) >> 32;
+        }
+    }
+  while ((seq & 1) != 0 || time_page->seq != seq);
+  return ns;
+}
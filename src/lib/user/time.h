@@ -0,0 +1,12 @@
+#ifndef __LIB_USER_TIME_H
+#define __LIB_USER_TIME_H
+
+#include <stdint.h>
+
+/* Reading the time.  These read the kernel's time page (see
+   lib/timepage.h) instead of making system calls. */
+int64_t gettime_ticks (void);
+unsigned gettime_freq (void);
+uint64_t gettime_ns (void);
+
+#endif /* lib/user/time.h */
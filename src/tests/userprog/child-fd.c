@@ -0,0 +1,31 @@
+/* Child process run by exec-fd test.
+
+   The first command-line argument is a descriptor for
+   "sample.txt" that its parent left open across exec(), the
+   second one a descriptor that exec() must have closed. */
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+
+const char *test_name = "child-fd";
+
+int
+main (int argc, char *argv[]) 
+{
+  int kept, closed;
+
+  msg ("begin");
+  if (argc != 3 || !isdigit (*argv[1]) || !isdigit (*argv[2]))
+    fail ("bad command-line arguments");
+  kept = atoi (argv[1]);
+  closed = atoi (argv[2]);
+
+  check_file_handle (kept, "sample.txt", sample, sizeof sample - 1);
+  CHECK (!set_cloexec (closed, false), "close-on-exec descriptor is closed");
+  msg ("end");
+
+  return 0;
+}
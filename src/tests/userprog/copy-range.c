@@ -0,0 +1,42 @@
+/* Copies "sample.txt" with copy_file_range() in two pieces,
+   checks the copy, and checks that copying a file onto an
+   overlapping range of itself fails. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  int in, out, byte_cnt;
+
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("copy.txt", sizeof sample - 1), "create \"copy.txt\"");
+  CHECK ((out = open ("copy.txt")) > 1, "open \"copy.txt\"");
+
+  byte_cnt = copy_file_range (in, out, 100);
+  if (byte_cnt != 100)
+    fail ("copy_file_range() returned %d instead of 100", byte_cnt);
+  byte_cnt = copy_file_range (in, out, 1000);
+  if (byte_cnt != sizeof sample - 1 - 100)
+    fail ("copy_file_range() returned %d instead of %zu",
+          byte_cnt, sizeof sample - 1 - 100);
+  CHECK (copy_file_range (in, out, 1000) == 0, "copy at end of file");
+  CHECK (tell (in) == sizeof sample - 1, "tell \"sample.txt\"");
+
+  seek (out, 0);
+  byte_cnt = read (out, buf, sizeof buf);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("read() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "copy.txt");
+  msg ("compare \"copy.txt\"");
+
+  seek (in, 0);
+  close (out);
+  CHECK ((out = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  seek (out, 10);
+  CHECK (copy_file_range (in, out, 100) == -1, "overlapping copy fails");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range) begin
+(copy-range) open "sample.txt"
+(copy-range) create "copy.txt"
+(copy-range) open "copy.txt"
+(copy-range) copy at end of file
+(copy-range) tell "sample.txt"
+(copy-range) compare "copy.txt"
+(copy-range) open "sample.txt" again
+(copy-range) overlapping copy fails
+(copy-range) end
+copy-range: exit(0)
+EOF
+pass;
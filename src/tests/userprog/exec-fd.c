@@ -0,0 +1,29 @@
+/* Opens "sample.txt" twice, clears close-on-exec on one of the
+   descriptors, and runs a child that must find that descriptor
+   open and the other one closed.  Along the way, checks that
+   open() reuses the lowest free descriptor. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char child_cmd[128];
+  int closed, kept, extra;
+
+  CHECK ((closed = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((extra = open ("sample.txt")) > closed, "open \"sample.txt\" again");
+  close (closed);
+  CHECK (open ("sample.txt") == closed, "open reuses lowest descriptor");
+  close (extra);
+  CHECK ((kept = open ("sample.txt")) == extra,
+         "open reuses closed descriptor");
+  CHECK (set_cloexec (kept, false), "set_cloexec");
+  CHECK (!set_cloexec (extra + 1, false), "set_cloexec on closed fd");
+
+  snprintf (child_cmd, sizeof child_cmd, "child-fd %d %d", kept, closed);
+  msg ("wait(exec()) = %d", wait (exec (child_cmd)));
+}
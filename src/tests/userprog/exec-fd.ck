@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(exec-fd) begin
+(exec-fd) open "sample.txt"
+(exec-fd) open "sample.txt" again
+(exec-fd) open reuses lowest descriptor
+(exec-fd) open reuses closed descriptor
+(exec-fd) set_cloexec
+(exec-fd) set_cloexec on closed fd
+(child-fd) begin
+(child-fd) verified contents of "sample.txt"
+(child-fd) close-on-exec descriptor is closed
+(child-fd) end
+child-fd: exit(0)
+(exec-fd) wait(exec()) = 0
+(exec-fd) end
+exec-fd: exit(0)
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Reads the time from the time page many times and checks that
+   it never goes backward and that the tick count and the time in
+   nanoseconds agree. */
+
+#include <time.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  uint64_t ns_per_tick = 1000000000u / gettime_freq ();
+  uint64_t last_ns = 0;
+  int64_t last_ticks = 0;
+  int i;
+
+  CHECK (gettime_freq () > 0, "gettime_freq");
+  for (i = 0; i < 100000; i++)
+    {
+      int64_t ticks = gettime_ticks ();
+      uint64_t ns = gettime_ns ();
+      int64_t ticks2 = gettime_ticks ();
+
+      if (ticks < last_ticks)
+        fail ("ticks went backward from %lld to %lld", last_ticks, ticks);
+      if (ns < last_ns)
+        fail ("time went backward from %llu to %llu ns", last_ns, ns);
+      if (ns < (uint64_t) ticks * ns_per_tick
+          || ns > (uint64_t) (ticks2 + 1) * ns_per_tick)
+        fail ("%llu ns is not between ticks %lld and %lld",
+              ns, ticks, ticks2 + 1);
+      last_ticks = ticks2;
+      last_ns = ns;
+    }
+  msg ("time is monotonic");
+}
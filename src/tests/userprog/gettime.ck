@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(gettime) begin
+(gettime) gettime_freq
+(gettime) time is monotonic
+(gettime) end
+gettime: exit(0)
+EOF
+pass;
@@ -0,0 +1,79 @@
+/* Opens, reads, and closes "sample.txt" through submission and
+   completion rings, and checks that an operation with a bad
+   buffer fails without killing the process. */
+
+#include <ioring.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct ioring *ring;
+
+/* Queues an operation in the submission ring. */
+static void
+queue (uint8_t op, int fd, void *addr, unsigned len, uint32_t user_data)
+{
+  struct ioring_sqe *sqe = &ring->sqes[ring->sq_tail % IORING_SQ_ENTRIES];
+
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->addr = addr;
+  sqe->len = len;
+  sqe->ofs = -1;
+  sqe->user_data = user_data;
+  ring->sq_tail++;
+}
+
+/* Submits the CNT queued operations, waits for them, and stores
+   each one's result in RESULTS[] indexed by its user data. */
+static void
+run (unsigned cnt, int results[])
+{
+  unsigned i;
+
+  CHECK (ioring_enter (cnt, cnt) == (int) cnt, "submit %u", cnt);
+  for (i = 0; i < cnt; i++)
+    {
+      struct ioring_cqe *cqe;
+
+      if (ring->cq_head == ring->cq_tail)
+        fail ("only %u of %u completions", i, cnt);
+      cqe = &ring->cqes[ring->cq_head % IORING_CQ_ENTRIES];
+      results[cqe->user_data] = cqe->res;
+      ring->cq_head++;
+    }
+}
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  int results[3];
+  int handle;
+
+  ring = ioring_setup ((void *) 0x10000000);
+  CHECK (ring != NULL, "ioring_setup");
+
+  queue (IORING_OP_OPEN, 0, "sample.txt", 0, 0);
+  run (1, results);
+  handle = results[0];
+  CHECK (handle > 1, "open \"sample.txt\"");
+
+  queue (IORING_OP_READ, handle, buf, sizeof buf, 0);
+  queue (IORING_OP_READ, handle, (void *) 0xc0000000, 16, 1);
+  queue (IORING_OP_NOP, 0, NULL, 0, 2);
+  run (3, results);
+  if (results[0] != sizeof sample - 1)
+    fail ("read returned %d instead of %zu", results[0], sizeof sample - 1);
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "sample.txt");
+  msg ("read \"sample.txt\"");
+  CHECK (results[1] == -1, "read into kernel memory fails");
+  CHECK (results[2] == 0, "nop");
+
+  queue (IORING_OP_CLOSE, handle, NULL, 0, 0);
+  queue (IORING_OP_CLOSE, handle + 1, NULL, 0, 1);
+  run (2, results);
+  CHECK (results[0] == 0, "close \"sample.txt\"");
+  CHECK (results[1] == -1, "close bad handle fails");
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ioring-read) begin
+(ioring-read) ioring_setup
+(ioring-read) submit 1
+(ioring-read) open "sample.txt"
+(ioring-read) submit 3
+(ioring-read) read "sample.txt"
+(ioring-read) read into kernel memory fails
+(ioring-read) nop
+(ioring-read) submit 2
+(ioring-read) close "sample.txt"
+(ioring-read) close bad handle fails
+(ioring-read) end
+ioring-read: exit(0)
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Reads "sample.txt" with readv() into buffers of uneven sizes,
+   then with pread() at an offset, and checks that pread() leaves
+   the file position where readv() put it. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char a[7], b[100], c[sizeof sample];
+  char buf[16];
+  struct iovec iov[3];
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  iov[0].iov_base = a;
+  iov[0].iov_len = sizeof a;
+  iov[1].iov_base = b;
+  iov[1].iov_len = sizeof b;
+  iov[2].iov_base = c;
+  iov[2].iov_len = sizeof c;
+  byte_cnt = readv (handle, iov, 3);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("readv() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  compare_bytes (a, sample, sizeof a, 0, "sample.txt");
+  compare_bytes (b, sample + sizeof a, sizeof b, sizeof a, "sample.txt");
+  compare_bytes (c, sample + sizeof a + sizeof b,
+                 sizeof sample - 1 - sizeof a - sizeof b,
+                 sizeof a + sizeof b, "sample.txt");
+  msg ("readv \"sample.txt\"");
+
+  byte_cnt = pread (handle, buf, sizeof buf, 42);
+  if (byte_cnt != sizeof buf)
+    fail ("pread() returned %d instead of %zu", byte_cnt, sizeof buf);
+  compare_bytes (buf, sample + 42, sizeof buf, 42, "sample.txt");
+  msg ("pread \"sample.txt\"");
+
+  CHECK (tell (handle) == sizeof sample - 1, "tell \"sample.txt\"");
+}
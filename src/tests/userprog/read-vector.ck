@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(read-vector) begin
+(read-vector) open "sample.txt"
+(read-vector) readv "sample.txt"
+(read-vector) pread "sample.txt"
+(read-vector) tell "sample.txt"
+(read-vector) end
+read-vector: exit(0)
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Writes "test.txt" with writev() from buffers of uneven sizes,
+   overwrites part of it with pwrite(), and checks that pwrite()
+   leaves the file position where writev() put it and that the
+   file ends up with the expected contents. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  struct iovec iov[3];
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", sizeof sample - 1), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  iov[0].iov_base = sample;
+  iov[0].iov_len = 13;
+  iov[1].iov_base = sample + 13;
+  iov[1].iov_len = 0;
+  iov[2].iov_base = sample + 13;
+  iov[2].iov_len = sizeof sample - 1 - 13;
+  byte_cnt = writev (handle, iov, 3);
+  if (byte_cnt != sizeof sample - 1)
+    fail ("writev() returned %d instead of %zu", byte_cnt, sizeof sample - 1);
+  msg ("writev \"test.txt\"");
+
+  byte_cnt = pwrite (handle, sample + 100, 50, 100);
+  if (byte_cnt != 50)
+    fail ("pwrite() returned %d instead of 50", byte_cnt);
+  msg ("pwrite \"test.txt\"");
+
+  CHECK (tell (handle) == sizeof sample - 1, "tell \"test.txt\"");
+  close (handle);
+
+  check_file ("test.txt", sample, sizeof sample - 1);
+}
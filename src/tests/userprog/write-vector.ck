@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(write-vector) begin
+(write-vector) create "test.txt"
+(write-vector) open "test.txt"
+(write-vector) writev "test.txt"
+(write-vector) pwrite "test.txt"
+(write-vector) tell "test.txt"
+(write-vector) open "test.txt" for verification
+(write-vector) verified contents of "test.txt"
+(write-vector) close "test.txt"
+(write-vector) end
+write-vector: exit(0)
+EOF
+pass;
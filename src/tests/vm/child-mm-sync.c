@@ -0,0 +1,27 @@
+/* Child process of mmap-sync.
+   Maps sample.txt while the parent still has it mapped and
+   verifies that it sees the data the parent wrote with
+   write(). */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x20000000)
+
+void
+test_main (void)
+{
+  static const char written[] = "written";
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (handle, ACTUAL) != MAP_FAILED, "mmap \"sample.txt\"");
+  CHECK (!memcmp (ACTUAL, written, strlen (written)),
+         "parent's write is visible in new mapping");
+  CHECK (!memcmp (ACTUAL + strlen (written), sample + strlen (written),
+                  100 - strlen (written)),
+         "rest of page is unchanged");
+}
@@ -0,0 +1,54 @@
+/* Forks a child that writes to a buffer it shares with its
+   parent copy-on-write, and checks that each process sees only
+   its own writes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (64 * 1024)
+
+static char buf[SIZE];
+
+/* Returns true if every byte in BUF is C. */
+static bool
+all_bytes (char c)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != c)
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  pid_t pid;
+
+  memset (buf, 'p', sizeof buf);
+
+  /* The child must not print: its output could interleave with
+     the parent's. */
+  msg ("fork");
+  pid = fork ();
+  if (pid == 0)
+    {
+      if (!all_bytes ('p'))
+        exit (1);
+      memset (buf, 'c', sizeof buf);
+      exit (all_bytes ('c') ? 81 : 2);
+    }
+  if (pid < 0)
+    fail ("fork returned %d", pid);
+
+  msg ("wait(fork()) = %d", wait (pid));
+  if (!all_bytes ('p'))
+    fail ("parent's buffer was modified by its child");
+
+  memset (buf, 'q', sizeof buf);
+  if (!all_bytes ('q'))
+    fail ("parent could not write its buffer");
+}
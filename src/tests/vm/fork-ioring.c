@@ -0,0 +1,58 @@
+/* Starts a read through the submission and completion rings and
+   forks without waiting for it.  fork() must let the read finish
+   first, so that parent and child both find all of the data in
+   their own copies of the buffer and the parent gets the
+   completion. */
+
+#include <ioring.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[sizeof sample];
+
+void
+test_main (void)
+{
+  struct ioring *ring;
+  struct ioring_sqe *sqe;
+  struct ioring_cqe *cqe;
+  int handle;
+  pid_t pid;
+
+  ring = ioring_setup ((void *) 0x10000000);
+  CHECK (ring != NULL, "ioring_setup");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  sqe = &ring->sqes[ring->sq_tail % IORING_SQ_ENTRIES];
+  sqe->op = IORING_OP_READ;
+  sqe->fd = handle;
+  sqe->addr = buf;
+  sqe->len = sizeof buf;
+  sqe->ofs = 0;
+  sqe->user_data = 42;
+  ring->sq_tail++;
+  CHECK (ioring_enter (1, 0) == 1, "submit read");
+
+  /* The child must not print: its output could interleave with
+     the parent's. */
+  msg ("fork");
+  pid = fork ();
+  if (pid == 0)
+    exit (memcmp (buf, sample, sizeof sample - 1) ? 1 : 81);
+  if (pid < 0)
+    fail ("fork returned %d", pid);
+  msg ("wait(fork()) = %d", wait (pid));
+
+  if (ring->cq_head == ring->cq_tail)
+    fail ("read did not complete before fork() returned");
+  cqe = &ring->cqes[ring->cq_head % IORING_CQ_ENTRIES];
+  if (cqe->user_data != 42 || cqe->res != sizeof sample - 1)
+    fail ("completion %u returned %d instead of %zu",
+          cqe->user_data, cqe->res, sizeof sample - 1);
+  ring->cq_head++;
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "sample.txt");
+  msg ("read \"sample.txt\"");
+}
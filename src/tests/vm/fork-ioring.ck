@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-ioring) begin
+(fork-ioring) ioring_setup
+(fork-ioring) open "sample.txt"
+(fork-ioring) submit read
+(fork-ioring) fork
+fork-ioring: exit(81)
+(fork-ioring) wait(fork()) = 81
+(fork-ioring) read "sample.txt"
+(fork-ioring) end
+fork-ioring: exit(0)
+EOF
+pass;
@@ -0,0 +1,27 @@
+/* Maps an empty file, fills it from "sample.txt" with
+   copy_file_range(), and verifies that the copy shows up in the
+   mapping, which already had the page in memory. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+  size_t size = strlen (sample);
+  int in, out;
+
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("copy.txt", size), "create \"copy.txt\"");
+  CHECK ((out = open ("copy.txt")) > 1, "open \"copy.txt\"");
+  CHECK (mmap (out, ACTUAL) != MAP_FAILED, "mmap \"copy.txt\"");
+  CHECK (ACTUAL[0] == 0, "mapping starts out zeroed");
+  CHECK (copy_file_range (in, out, size) == (int) size,
+         "copy \"sample.txt\" to \"copy.txt\"");
+  CHECK (!memcmp (ACTUAL, sample, size), "copy is visible in mapping");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-copy) begin
+(mmap-copy) open "sample.txt"
+(mmap-copy) create "copy.txt"
+(mmap-copy) open "copy.txt"
+(mmap-copy) mmap "copy.txt"
+(mmap-copy) mapping starts out zeroed
+(mmap-copy) copy "sample.txt" to "copy.txt"
+(mmap-copy) copy is visible in mapping
+(mmap-copy) end
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Maps the same file into memory twice, writes through one
+   mapping, and verifies that the write is visible through the
+   other at once, because both mappings share the same frames. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char *actual[2] = {(char *) 0x10000000, (char *) 0x20000000};
+  static const char overwrite[] = "shared";
+  size_t i;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  for (i = 0; i < 2; i++)
+    CHECK (mmap (handle, actual[i]) != MAP_FAILED,
+           "mmap \"sample.txt\" #%zu at %p", i, (void *) actual[i]);
+
+  /* Touch the second mapping first, so that both have the page
+     in memory before the write. */
+  CHECK (!memcmp (actual[1], sample, strlen (sample)),
+         "compare mmap'd file 1 against data");
+  memcpy (actual[0], overwrite, strlen (overwrite));
+  CHECK (!memcmp (actual[1], overwrite, strlen (overwrite)),
+         "write through mapping 0 is visible in mapping 1");
+  CHECK (!memcmp (actual[1] + strlen (overwrite), sample + strlen (overwrite),
+                  strlen (sample) - strlen (overwrite)),
+         "rest of mapping 1 is unchanged");
+}
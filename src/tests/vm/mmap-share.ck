@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-share) begin
+(mmap-share) open "sample.txt"
+(mmap-share) mmap "sample.txt" #0 at 0x10000000
+(mmap-share) mmap "sample.txt" #1 at 0x20000000
+(mmap-share) compare mmap'd file 1 against data
+(mmap-share) write through mapping 0 is visible in mapping 1
+(mmap-share) rest of mapping 1 is unchanged
+(mmap-share) end
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Writes to a file with write() while the file is mapped, and
+   verifies that the write shows up in the mapping, in another
+   process that maps the file afterward, and in the file after
+   the mapping, which was modified as well, is unmapped. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+  static const char written[] = "written";
+  static const char mapped[] = "mapped";
+  char expected[sizeof sample];
+  mapid_t map;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (handle, ACTUAL)) != MAP_FAILED, "mmap \"sample.txt\"");
+
+  /* Modify the mapping, so that unmapping it writes it back. */
+  memcpy (ACTUAL + 100, mapped, strlen (mapped));
+  CHECK (write (handle, written, strlen (written)) == (int) strlen (written),
+         "write \"sample.txt\"");
+  CHECK (!memcmp (ACTUAL, written, strlen (written)),
+         "write is visible in mapping");
+  CHECK (wait (exec ("child-mm-sync")) == 0, "wait for child-mm-sync");
+  munmap (map);
+  close (handle);
+
+  memcpy (expected, sample, sizeof sample);
+  memcpy (expected, written, strlen (written));
+  memcpy (expected + 100, mapped, strlen (mapped));
+  check_file ("sample.txt", expected, strlen (sample));
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-sync) begin
+(mmap-sync) open "sample.txt"
+(mmap-sync) mmap "sample.txt"
+(mmap-sync) write "sample.txt"
+(mmap-sync) write is visible in mapping
+(child-mm-sync) begin
+(child-mm-sync) open "sample.txt"
+(child-mm-sync) mmap "sample.txt"
+(child-mm-sync) parent's write is visible in new mapping
+(child-mm-sync) rest of page is unchanged
+(child-mm-sync) end
+(mmap-sync) wait for child-mm-sync
+(mmap-sync) open "sample.txt" for verification
+(mmap-sync) verified contents of "sample.txt"
+(mmap-sync) close "sample.txt"
+(mmap-sync) end
+EOF
+pass;
@@ -0,0 +1,58 @@
+/* Fills 2 MB of memory with a mix of pages that compress well
+   and pages that do not, so that the compressed swap pool and
+   the swap disk are both used, then verifies every page twice. */
+
+#include <string.h>
+#include "tests/arc4.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 1024 * 1024)
+#define PAGE 4096
+
+static char buf[SIZE];
+
+/* Fills or, if CHECK, verifies page PAGE_NO of BUF.  Even pages
+   hold repetitive text, odd pages hold random bytes. */
+static void
+do_page (size_t page_no, bool check)
+{
+  static const char text[] = "the quick brown fox jumps over the lazy dog ";
+  char *page = buf + page_no * PAGE;
+  char expected[PAGE];
+  size_t i;
+
+  if (page_no % 2 == 0)
+    for (i = 0; i < PAGE; i++)
+      expected[i] = text[(i + page_no) % (sizeof text - 1)];
+  else
+    {
+      struct arc4 arc4;
+      arc4_init (&arc4, &page_no, sizeof page_no);
+      memset (expected, 0, PAGE);
+      arc4_crypt (&arc4, expected, PAGE);
+    }
+
+  if (!check)
+    memcpy (page, expected, PAGE);
+  else if (memcmp (page, expected, PAGE))
+    fail ("page %zu has wrong contents", page_no);
+}
+
+void
+test_main (void)
+{
+  size_t i;
+
+  msg ("initialize");
+  for (i = 0; i < SIZE / PAGE; i++)
+    do_page (i, false);
+
+  msg ("check pass one");
+  for (i = 0; i < SIZE / PAGE; i++)
+    do_page (i, true);
+
+  msg ("check pass two");
+  for (i = SIZE / PAGE; i-- > 0; )
+    do_page (i, true);
+}
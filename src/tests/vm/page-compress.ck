@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-compress) begin
+(page-compress) initialize
+(page-compress) check pass one
+(page-compress) check pass two
+(page-compress) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Causes page faults of known classes and checks that the
+   faultstat() system call counts them, both for this process
+   and for the whole system. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_CNT 64
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_CNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct fault_stats before, after, sys;
+  size_t i;
+
+  CHECK (faultstat (true, &before), "faultstat (self)");
+
+  /* Reads map the zero frame; writes then copy it. */
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * PAGE_SIZE] != 0)
+      fail ("page %zu is not zeroed", i);
+  for (i = 0; i < PAGE_CNT; i++)
+    buf[i * PAGE_SIZE] = 1;
+
+  CHECK (faultstat (true, &after), "faultstat (self) again");
+  CHECK (after.count[FAULT_ZERO] - before.count[FAULT_ZERO] >= PAGE_CNT,
+         "at least %d zero-fill faults", PAGE_CNT);
+  CHECK (after.count[FAULT_COW] - before.count[FAULT_COW] >= PAGE_CNT,
+         "at least %d copy-on-write faults", PAGE_CNT);
+
+  CHECK (faultstat (false, &sys), "faultstat (system)");
+  for (i = 0; i < FAULT_CLASS_CNT; i++)
+    {
+      uint64_t hist_sum = 0;
+      int b;
+
+      if (sys.count[i] < after.count[i])
+        fail ("class %zu: system count below process count", i);
+      for (b = 0; b < FAULT_HIST_BUCKETS; b++)
+        hist_sum += sys.hist[i][b];
+      if (hist_sum < sys.count[i])
+        fail ("class %zu: histogram is missing faults", i);
+    }
+
+  CHECK (!faultstat (true, (struct fault_stats *) 0xc0000000),
+         "faultstat into kernel memory must fail");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-faultstat) begin
+(page-faultstat) faultstat (self)
+(page-faultstat) faultstat (self) again
+(page-faultstat) at least 64 zero-fill faults
+(page-faultstat) at least 64 copy-on-write faults
+(page-faultstat) faultstat (system)
+(page-faultstat) faultstat into kernel memory must fail
+(page-faultstat) end
+EOF
+pass;
@@ -0,0 +1,66 @@
+/* Fills many pages with the same table, and others with zeros
+   written explicitly, then idles in the file system so that the
+   kernel's same-page merging thread can merge them.  Then writes
+   a different value to each page and checks that every page
+   kept its own contents, which tests that merged pages are
+   split again on write. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 256
+
+static unsigned char buf[PAGE_CNT][PAGE_SIZE];
+
+/* Returns the expected value of byte I of page P, after the
+   writes if WRITTEN is true. */
+static unsigned char
+expected (size_t p, size_t i, bool written)
+{
+  if (written && i == 0)
+    return p & 0xff;
+  else if (written && i == 1)
+    return p >> 8;
+  else
+    return p % 2 ? i * 7 % 251 : 0;
+}
+
+void
+test_main (void)
+{
+  char block[512];
+  size_t p, i;
+  int round;
+
+  msg ("fill");
+  for (p = 0; p < PAGE_CNT; p++)
+    for (i = 0; i < PAGE_SIZE; i++)
+      buf[p][i] = expected (p, i, false);
+
+  msg ("idle");
+  for (round = 0; round < 64; round++)
+    {
+      int fd;
+      CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+      while (read (fd, block, sizeof block) > 0)
+        continue;
+      close (fd);
+    }
+
+  msg ("write");
+  for (p = 0; p < PAGE_CNT; p++)
+    {
+      buf[p][0] = expected (p, 0, true);
+      buf[p][1] = expected (p, 1, true);
+    }
+
+  msg ("check");
+  for (p = 0; p < PAGE_CNT; p++)
+    for (i = 0; i < PAGE_SIZE; i++)
+      if (buf[p][i] != expected (p, i, true))
+        fail ("byte %zu of page %zu is %d, should be %d",
+              i, p, buf[p][i], expected (p, i, true));
+}
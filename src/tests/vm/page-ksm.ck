@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-ksm) begin
+(page-ksm) fill
+(page-ksm) idle
+(page-ksm) write
+(page-ksm) check
+(page-ksm) end
+EOF
+pass;
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-linear-rss) begin
+(page-linear-rss) initialize
+(page-linear-rss) read pass
+(page-linear-rss) read/modify/write pass one
+(page-linear-rss) read/modify/write pass two
+(page-linear-rss) read pass
+(page-linear-rss) end
+EOF
+pass;
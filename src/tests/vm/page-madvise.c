@@ -0,0 +1,55 @@
+/* Exercises every kind of madvise() advice on a large array:
+   checks that SEQUENTIAL, RANDOM, and WILLNEED leave its
+   contents intact and that DONTNEED resets the pages it covers
+   to zeros, their initial contents. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (1024 * 1024)
+#define PAGE_SIZE 4096
+
+static char buf[SIZE];
+
+/* Checks that each byte in BUF[START...END) has the value that
+   fill() gave it, or is zero if ZERO is true. */
+static void
+check (size_t start, size_t end, bool zero)
+{
+  size_t i;
+
+  for (i = start; i < end; i++)
+    if (buf[i] != (zero ? 0 : (char) (i * 31 / 7)))
+      fail ("byte %zu is %d", i, buf[i]);
+}
+
+void
+test_main (void)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    buf[i] = i * 31 / 7;
+
+  CHECK (madvise (buf, SIZE, MADV_SEQUENTIAL), "madvise SEQUENTIAL");
+  check (0, SIZE, false);
+  CHECK (madvise (buf, SIZE, MADV_RANDOM), "madvise RANDOM");
+  check (0, SIZE, false);
+  CHECK (madvise (buf, SIZE, MADV_WILLNEED), "madvise WILLNEED");
+  check (0, SIZE, false);
+  CHECK (madvise (buf, SIZE, MADV_NORMAL), "madvise NORMAL");
+
+  CHECK (madvise (buf + 16 * PAGE_SIZE, 32 * PAGE_SIZE, MADV_DONTNEED),
+         "madvise DONTNEED");
+  check (0, 16 * PAGE_SIZE, false);
+  check (16 * PAGE_SIZE, 48 * PAGE_SIZE, true);
+  check (48 * PAGE_SIZE, SIZE, false);
+
+  CHECK (!madvise (buf + 1, PAGE_SIZE, MADV_NORMAL),
+         "madvise on misaligned address must fail");
+  CHECK (!madvise (buf, PAGE_SIZE, 99), "madvise with bad advice must fail");
+  CHECK (!madvise ((void *) 0x20000000, PAGE_SIZE, MADV_NORMAL),
+         "madvise on unmapped memory must fail");
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-madvise) begin
+(page-madvise) madvise SEQUENTIAL
+(page-madvise) madvise RANDOM
+(page-madvise) madvise WILLNEED
+(page-madvise) madvise NORMAL
+(page-madvise) madvise DONTNEED
+(page-madvise) madvise on misaligned address must fail
+(page-madvise) madvise with bad advice must fail
+(page-madvise) madvise on unmapped memory must fail
+(page-madvise) end
+EOF
+pass;
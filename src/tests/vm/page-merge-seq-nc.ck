@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-merge-seq-nc) begin
+(page-merge-seq-nc) init
+(page-merge-seq-nc) sort chunk 0
+(page-merge-seq-nc) sort chunk 1
+(page-merge-seq-nc) sort chunk 2
+(page-merge-seq-nc) sort chunk 3
+(page-merge-seq-nc) sort chunk 4
+(page-merge-seq-nc) sort chunk 5
+(page-merge-seq-nc) sort chunk 6
+(page-merge-seq-nc) sort chunk 7
+(page-merge-seq-nc) sort chunk 8
+(page-merge-seq-nc) sort chunk 9
+(page-merge-seq-nc) sort chunk 10
+(page-merge-seq-nc) sort chunk 11
+(page-merge-seq-nc) sort chunk 12
+(page-merge-seq-nc) sort chunk 13
+(page-merge-seq-nc) sort chunk 14
+(page-merge-seq-nc) sort chunk 15
+(page-merge-seq-nc) merge
+(page-merge-seq-nc) verify
+(page-merge-seq-nc) success, buf_idx=1,032,192
+(page-merge-seq-nc) end
+EOF
+pass;
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-tlb-lp) begin
+(page-tlb-lp) initialize
+(page-tlb-lp) strided passes
+(page-tlb-lp) check
+(page-tlb-lp) end
+EOF
+pass;
@@ -0,0 +1,41 @@
+/* Touches one byte in every page of a 4 MB buffer, many times
+   over, in a scattered order that keeps missing in the TLB when
+   the buffer is mapped with 4 kB pages.
+
+   The same program is run as page-tlb-lp with the kernel's -lp
+   option, which maps the buffer with a single 4 MB page.
+   Compare the user ticks that the two runs report at shutdown
+   to see the difference in TLB reach. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (4 * 1024 * 1024)
+#define PAGE_SIZE 4096
+#define PAGE_CNT (SIZE / PAGE_SIZE)
+#define PASSES 256
+
+/* Aligned so that it can be covered by one large page. */
+static char buf[SIZE] __attribute__ ((aligned (SIZE)));
+
+void
+test_main (void)
+{
+  size_t pass, i;
+
+  msg ("initialize");
+  memset (buf, 0, sizeof buf);
+
+  /* Visit the pages in a stride-97 permutation, since 97 is
+     relatively prime to PAGE_CNT. */
+  msg ("strided passes");
+  for (pass = 0; pass < PASSES; pass++)
+    for (i = 0; i < PAGE_CNT; i++)
+      buf[(i * 97 % PAGE_CNT) * PAGE_SIZE + pass]++;
+
+  msg ("check");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != (i % PAGE_SIZE < PASSES))
+      fail ("byte %zu is %d", i, buf[i]);
+}
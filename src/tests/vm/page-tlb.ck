@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-tlb) begin
+(page-tlb) initialize
+(page-tlb) strided passes
+(page-tlb) check
+(page-tlb) end
+EOF
+pass;
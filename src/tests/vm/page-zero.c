@@ -0,0 +1,32 @@
+/* Reads every page of a large zero-filled array, which should
+   all be backed by the kernel's single zero frame, then writes
+   to a few of them and checks that only those changed. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 1024 * 1024)
+#define PAGE_SIZE 4096
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+
+  msg ("read zeros");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu is %d before any write", i, buf[i]);
+
+  msg ("write every 64th page");
+  for (i = 0; i < SIZE; i += 64 * PAGE_SIZE)
+    buf[i] = 1;
+
+  msg ("check");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != (i % (64 * PAGE_SIZE) == 0))
+      fail ("byte %zu is %d after writes", i, buf[i]);
+}
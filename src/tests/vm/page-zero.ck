@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-zero) begin
+(page-zero) read zeros
+(page-zero) write every 64th page
+(page-zero) check
+(page-zero) end
+EOF
+pass;
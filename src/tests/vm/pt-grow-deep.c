@@ -0,0 +1,35 @@
+/* Recurses deeply enough to grow the stack by about 1 MB, one
+   page at a time, and checks that every frame kept its data.
+   The stack growth statistics printed at shutdown show how many
+   of those pages were mapped ahead of a fault. */
+
+#include <string.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DEPTH 256
+
+/* Fills a page-sized local array with a pattern that depends on
+   DEPTH, recurses, and then verifies the pattern.  Returns the
+   number of frames checked. */
+static int
+recurse (int depth)
+{
+  char buf[4096];
+  int cnt = 1;
+  size_t i;
+
+  memset (buf, depth, sizeof buf);
+  if (depth > 0)
+    cnt += recurse (depth - 1);
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != (char) depth)
+      fail ("byte %zu at depth %d is %d", i, depth, buf[i]);
+  return cnt;
+}
+
+void
+test_main (void)
+{
+  msg ("recursed through %d frames", recurse (DEPTH - 1));
+}
@@ -0,0 +1,79 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Feature bits returned in EDX by CPUID leaf 1.
+   See [IA32-v2a] "CPUID". */
+#define CPUID_PSE  (1u << 3)    /* 4 MB pages. */
+#define CPUID_TSC  (1u << 4)    /* Time stamp counter. */
+#define CPUID_MSR  (1u << 5)    /* RDMSR and WRMSR. */
+#define CPUID_SEP  (1u << 11)   /* SYSENTER and SYSEXIT. */
+#define CPUID_PGE  (1u << 13)   /* Global pages. */
+
+/* Control register 4 bits.  See [IA32-v3a] 2.5 "Control
+   Registers". */
+#define CR4_PSE 0x00000010      /* Page Size Extensions. */
+#define CR4_PGE 0x00000080      /* Page Global Enable. */
+
+/* Model-specific registers.  See [IA32-v3b] appendix B
+   "Model-Specific Registers (MSRs)". */
+#define MSR_SYSENTER_CS  0x174  /* SYSENTER target code segment. */
+#define MSR_SYSENTER_ESP 0x175  /* SYSENTER target stack pointer. */
+#define MSR_SYSENTER_EIP 0x176  /* SYSENTER target instruction. */
+
+/* Returns true if the CPU reports all of the CPUID leaf 1 EDX
+   feature bits in FEATURES. */
+static inline bool
+cpu_has (uint32_t features)
+{
+  /* See [IA32-v2a] "CPUID". */
+  uint32_t eax = 1, ebx, ecx = 0, edx;
+  asm ("cpuid" : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+  return (edx & features) == features;
+}
+
+/* Returns the contents of CR4. */
+static inline uint32_t
+cpu_read_cr4 (void)
+{
+  uint32_t cr4;
+  asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+  return cr4;
+}
+
+/* Stores CR4 into control register 4. */
+static inline void
+cpu_write_cr4 (uint32_t cr4)
+{
+  asm volatile ("movl %0, %%cr4" : : "r" (cr4) : "memory");
+}
+
+/* Stores VALUE into model-specific register MSR.  See
+   [IA32-v2b] "WRMSR". */
+static inline void
+cpu_write_msr (uint32_t msr, uint64_t value)
+{
+  asm volatile ("wrmsr" : : "c" (msr), "A" (value));
+}
+
+/* Returns the time stamp counter.  Only meaningful if
+   cpu_has (CPUID_TSC).  See [IA32-v2b] "RDTSC". */
+static inline uint64_t
+cpu_rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Invalidates the TLB entry, if any, for the page that contains
+   VADDR.  See [IA32-v2a] "INVLPG". */
+static inline void
+cpu_invlpg (const void *vaddr)
+{
+  asm volatile ("invlpg (%0)" : : "r" (vaddr) : "memory");
+}
+
+#endif /* threads/cpu.h */
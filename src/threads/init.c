@@ -15,18 +15,23 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#include "threads/memstat.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/shrinker.h"
 #include "threads/thread.h"
 #include "threads/alarm.h"
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/elfcache.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
+#include "userprog/ioring.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
 #else
@@ -38,10 +43,20 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/ksm.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#include "vm/zswap.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
 
+/* True if the CPU supports 4 MB pages and they are enabled. */
+bool init_large_pages;
+
 #ifdef FILESYS
 /* -f: Format the file system? */
 static bool format_filesys;
@@ -97,6 +112,7 @@ main (void)
           init_ram_pages * PGSIZE / 1024);
 
   /* Initialize memory system. */
+  shrinker_init ();
   palloc_init (user_page_limit);
   malloc_init ();
   paging_init ();
@@ -115,10 +131,12 @@ main (void)
 #ifdef USERPROG
   exception_init ();
   syscall_init ();
+  process_init ();
 #endif
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
+  shrinker_start ();
   serial_init_queue ();
   timer_calibrate ();
 
@@ -128,6 +146,17 @@ main (void)
   locate_block_devices ();
   filesys_init (format_filesys);
 #endif
+#ifdef USERPROG
+  ioring_init ();
+  elf_cache_init ();
+#endif
+
+#ifdef VM
+  /* Initialize virtual memory. */
+  frame_init ();
+  swap_init ();
+  ksm_init ();
+#endif
 
   printf ("Boot complete.\n");
   
@@ -155,14 +184,33 @@ bss_init (void)
 /* Populates the base page directory and page table with the
    kernel virtual mapping, and then sets up the CPU to use the
    new page directory.  Points init_page_dir to the page
-   directory it creates. */
+   directory it creates.
+
+   If the CPU supports 4 MB pages, each 4 MB of physical memory
+   that lies entirely in RAM and does not overlap the kernel's
+   code is mapped with a single large page instead of a page
+   table, which saves page tables and TLB entries.  If the CPU
+   supports global pages, the kernel mapping is also marked
+   global, so that the TLB keeps it across the CR3 reloads done
+   in pagedir_activate(). */
 static void
 paging_init (void)
 {
   uint32_t *pd, *pt;
+  uint32_t global = 0;
   size_t page;
   extern char _start, _end_kernel_text;
 
+  /* See [IA32-v3a] 3.7.3 "Mixing 4-KByte and 4-MByte Pages" and
+     3.11 "Translation Lookaside Buffers (TLBs)". */
+  if (cpu_has (CPUID_PSE))
+    {
+      cpu_write_cr4 (cpu_read_cr4 () | CR4_PSE);
+      init_large_pages = true;
+    }
+  if (cpu_has (CPUID_PGE))
+    global = PTE_G;
+
   pd = init_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   pt = NULL;
   for (page = 0; page < init_ram_pages; page++)
@@ -173,13 +221,22 @@ paging_init (void)
       size_t pte_idx = pt_no (vaddr);
       bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;
 
+      if (init_large_pages && pte_idx == 0
+          && page + PTSPAN / PGSIZE <= init_ram_pages
+          && (vaddr + PTSPAN <= &_start || vaddr >= &_end_kernel_text))
+        {
+          pd[pde_idx] = pde_create_large_kernel (vaddr, true) | global;
+          page += PTSPAN / PGSIZE - 1;
+          continue;
+        }
+
       if (pd[pde_idx] == 0)
         {
           pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
           pd[pde_idx] = pde_create (pt);
         }
 
-      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text);
+      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text) | global;
     }
 
   /* Store the physical address of the page directory into CR3
@@ -188,6 +245,10 @@ paging_init (void)
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)));
+
+  /* Global pages may be enabled only once paging is on. */
+  if (global)
+    cpu_write_cr4 (cpu_read_cr4 () | CR4_PGE);
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -252,15 +313,33 @@ parse_options (char **argv)
 #ifdef VM
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
+      else if (!strcmp (name, "-sc"))
+        swap_cluster = atoi (value);
+      else if (!strcmp (name, "-zs"))
+        zswap_pool_pages = atoi (value);
+      else if (!strcmp (name, "-stack"))
+        stack_max_pages = atoi (value);
+      else if (!strcmp (name, "-rss"))
+        rss_max_pages = atoi (value);
+      else if (!strcmp (name, "-ksm"))
+        ksm_pages_per_pass = atoi (value);
+      else if (!strcmp (name, "-ksm-sleep"))
+        ksm_sleep_ms = atoi (value);
 #endif
 #endif
       else if (!strcmp (name, "-rs"))
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-mtrace"))
+        memstat_enabled = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+      else if (!strcmp (name, "-lp"))
+        process_large_pages = true;
+      else if (!strcmp (name, "-ioring"))
+        ioring_worker_cnt = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -294,6 +373,16 @@ run_task (char **argv)
   printf ("Execution of '%s' complete.\n", task);
 }
 
+/* Prints memory allocation statistics. */
+static void
+run_memstat (char **argv UNUSED)
+{
+  if (memstat_enabled)
+    memstat_print_stats ();
+  else
+    printf ("memstat: allocation tracing is off (use -mtrace)\n");
+}
+
 /* Executes all of the actions specified in ARGV[]
    up to the null pointer sentinel. */
 static void
@@ -311,6 +400,7 @@ run_actions (char **argv)
   static const struct action actions[] = 
     {
       {"run", 2, run_task},
+      {"memstat", 1, run_memstat},
 #ifdef FILESYS
       {"ls", 1, fsutil_ls},
       {"cat", 2, fsutil_cat},
@@ -359,6 +449,7 @@ usage (void)
 #else
           "  run TEST           Run TEST.\n"
 #endif
+          "  memstat            Print memory allocation statistics.\n"
 #ifdef FILESYS
           "  ls                 List files in the root directory.\n"
           "  cat FILE           Print FILE to the console.\n"
@@ -377,12 +468,21 @@ usage (void)
           "  -scratch=BDEV      Use BDEV for scratch instead of default.\n"
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
+          "  -sc=COUNT          Swap COUNT pages at a time (default 8).\n"
+          "  -zs=COUNT          Compress up to COUNT pages of swap in RAM (default 64).\n"
+          "  -stack=COUNT       Limit user stacks to COUNT pages (default 2048).\n"
+          "  -rss=COUNT         Limit each process to COUNT resident pages.\n"
+          "  -ksm=COUNT         Merge identical pages, scanning COUNT frames per pass.\n"
+          "  -ksm-sleep=MS      Sleep MS ms between merging passes (default 50).\n"
 #endif
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -mtrace            Trace memory allocations by callsite.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+          "  -lp                Map large user segments with 4 MB pages.\n"
+          "  -ioring=COUNT      Run I/O rings with COUNT threads (default 2).\n"
 #endif
           );
   shutdown_power_off ();
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/memstat.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -32,7 +33,12 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   When allocation tracing is enabled, every block handed out
+   is preceded by a small tag that records the requested size
+   and the memstat site that requested it, so that free() can
+   credit the bytes back to the right caller. */
 
 /* Descriptor. */
 struct desc
@@ -60,12 +66,24 @@ struct block
     struct list_elem free_elem; /* Free list element. */
   };
 
+/* Allocation tag, placed in front of each block when allocation
+   tracing is enabled.  Its size keeps blocks 8-byte aligned. */
+struct tag
+  {
+    memstat_site_t site;        /* Site that allocated the block. */
+    uint16_t unused;            /* Padding. */
+    uint32_t size;              /* Requested size in bytes. */
+  };
+
 /* Our set of descriptors. */
 static struct desc descs[10];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static void *malloc_at (size_t, const void *caller);
+static void *tag_block (void *, size_t, const void *caller);
+static void *untag_block (void *);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -89,6 +107,15 @@ malloc_init (void)
 void *
 malloc (size_t size) 
 {
+  return malloc_at (size, __builtin_return_address (0));
+}
+
+/* Does the work of malloc(), attributing the allocation to
+   CALLER if allocation tracing is enabled. */
+static void *
+malloc_at (size_t size, const void *caller)
+{
+  size_t request = size;
   struct desc *d;
   struct block *b;
   struct arena *a;
@@ -96,6 +123,8 @@ malloc (size_t size)
   /* A null pointer satisfies a request for 0 bytes. */
   if (size == 0)
     return NULL;
+  if (memstat_enabled)
+    size += sizeof (struct tag);
 
   /* Find the smallest descriptor that satisfies a SIZE-byte
      request. */
@@ -116,7 +145,7 @@ malloc (size_t size)
       a->magic = ARENA_MAGIC;
       a->desc = NULL;
       a->free_cnt = page_cnt;
-      return a + 1;
+      return tag_block (a + 1, request, caller);
     }
 
   lock_acquire (&d->lock);
@@ -150,7 +179,7 @@ malloc (size_t size)
   a = block_to_arena (b);
   a->free_cnt--;
   lock_release (&d->lock);
-  return b;
+  return tag_block (b, request, caller);
 }
 
 /* Allocates and return A times B bytes initialized to zeroes.
@@ -167,7 +196,7 @@ calloc (size_t a, size_t b)
     return NULL;
 
   /* Allocate and zero memory. */
-  p = malloc (size);
+  p = malloc_at (size, __builtin_return_address (0));
   if (p != NULL)
     memset (p, 0, size);
 
@@ -178,7 +207,12 @@ calloc (size_t a, size_t b)
 static size_t
 block_size (void *block) 
 {
-  struct block *b = block;
+  struct block *b;
+
+  if (memstat_enabled)
+    return ((struct tag *) block)[-1].size;
+
+  b = block;
   struct arena *a = block_to_arena (b);
   struct desc *d = a->desc;
 
@@ -201,7 +235,7 @@ realloc (void *old_block, size_t new_size)
     }
   else 
     {
-      void *new_block = malloc (new_size);
+      void *new_block = malloc_at (new_size, __builtin_return_address (0));
       if (old_block != NULL && new_block != NULL)
         {
           size_t old_size = block_size (old_block);
@@ -220,7 +254,7 @@ free (void *p)
 {
   if (p != NULL)
     {
-      struct block *b = p;
+      struct block *b = untag_block (p);
       struct arena *a = block_to_arena (b);
       struct desc *d = a->desc;
       
@@ -263,6 +297,40 @@ free (void *p)
     }
 }
 
+/* If allocation tracing is enabled, records that BLOCK was
+   allocated by CALLER to hold SIZE bytes and returns the address
+   just past the tag that records it.  Otherwise, returns BLOCK
+   unchanged. */
+static void *
+tag_block (void *block, size_t size, const void *caller)
+{
+  struct tag *t = block;
+
+  if (!memstat_enabled)
+    return block;
+
+  t->site = memstat_alloc (caller, size, 0);
+  t->size = size;
+  return t + 1;
+}
+
+/* Reverses tag_block(): if allocation tracing is enabled,
+   credits the tagged block at P back to its site and returns
+   the address of the underlying block.  Otherwise, returns P
+   unchanged. */
+static void *
+untag_block (void *p)
+{
+  struct tag *t = p;
+
+  if (!memstat_enabled)
+    return p;
+
+  t--;
+  memstat_free (t->site, t->size, 0);
+  return t;
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
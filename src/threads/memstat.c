@@ -0,0 +1,190 @@
+#include "threads/memstat.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
+
+/* Memory allocation tracing.
+
+   Callsites are kept in a small open-addressed table indexed by
+   a hash of the caller's address.  The table is fixed in size
+   so that tracing never needs to allocate memory itself.  If it
+   fills up, further callsites are lumped together in a single
+   overflow entry.
+
+   The table is updated with interrupts disabled, because pages
+   are freed with interrupts off when a dying thread is
+   destroyed. */
+
+/* Number of entries in the callsite table, including the unused
+   entry 0 and the overflow entry. */
+#define SITE_CNT 256
+#define SITE_OVERFLOW (SITE_CNT - 1)
+
+/* Statistics for one calling site. */
+struct site
+  {
+    const void *caller;         /* Return address of allocator call. */
+    size_t live_bytes;          /* Bytes currently allocated. */
+    size_t live_pages;          /* Pages currently allocated. */
+    size_t peak_bytes;          /* Maximum of live_bytes. */
+    size_t peak_pages;          /* Maximum of live_pages. */
+    unsigned long long alloc_cnt;   /* Number of allocations. */
+    unsigned long long free_cnt;    /* Number of frees. */
+  };
+
+/* If false (default), allocations are not traced.
+   Controlled by kernel command-line option "-mtrace". */
+bool memstat_enabled;
+
+/* Callsite table. */
+static struct site sites[SITE_CNT];
+
+/* Totals over all sites. */
+static size_t live_bytes, live_pages;
+static size_t peak_bytes, peak_pages;
+static unsigned long long alloc_cnt;
+
+/* Allocation rate over the most recent full second. */
+static int64_t window_start;            /* Tick at start of window. */
+static unsigned long long window_cnt;   /* Allocations in window. */
+static unsigned long long window_rate;  /* Allocations in last window. */
+
+/* Returns the site for CALLER, creating it if necessary. */
+static memstat_site_t
+lookup_site (const void *caller)
+{
+  size_t start = ((uintptr_t) caller >> 2) % (SITE_OVERFLOW - 1) + 1;
+  size_t i = start;
+
+  do
+    {
+      struct site *s = &sites[i];
+      if (s->caller == caller)
+        return i;
+      else if (s->caller == NULL)
+        {
+          s->caller = caller;
+          return i;
+        }
+      if (++i >= SITE_OVERFLOW)
+        i = 1;
+    }
+  while (i != start);
+
+  return SITE_OVERFLOW;
+}
+
+/* Records an allocation of BYTES bytes and PAGES pages made by
+   the code that called the allocator at CALLER.  Returns the
+   site to pass to memstat_free() when the allocation is
+   released. */
+memstat_site_t
+memstat_alloc (const void *caller, size_t bytes, size_t pages)
+{
+  enum intr_level old_level;
+  memstat_site_t id;
+  struct site *s;
+  int64_t now;
+
+  ASSERT (memstat_enabled);
+
+  now = timer_ticks ();
+  old_level = intr_disable ();
+  id = lookup_site (caller);
+  s = &sites[id];
+  s->alloc_cnt++;
+  s->live_bytes += bytes;
+  s->live_pages += pages;
+  if (s->live_bytes > s->peak_bytes)
+    s->peak_bytes = s->live_bytes;
+  if (s->live_pages > s->peak_pages)
+    s->peak_pages = s->live_pages;
+
+  alloc_cnt++;
+  live_bytes += bytes;
+  live_pages += pages;
+  if (live_bytes > peak_bytes)
+    peak_bytes = live_bytes;
+  if (live_pages > peak_pages)
+    peak_pages = live_pages;
+
+  if (now - window_start >= TIMER_FREQ)
+    {
+      window_rate = now - window_start < 2 * TIMER_FREQ ? window_cnt : 0;
+      window_start = now;
+      window_cnt = 0;
+    }
+  window_cnt++;
+  intr_set_level (old_level);
+
+  return id;
+}
+
+/* Records that an allocation of BYTES bytes and PAGES pages
+   previously attributed to site ID has been freed. */
+void
+memstat_free (memstat_site_t id, size_t bytes, size_t pages)
+{
+  enum intr_level old_level;
+  struct site *s;
+
+  ASSERT (id > 0 && id < SITE_CNT);
+
+  old_level = intr_disable ();
+  s = &sites[id];
+  ASSERT (s->live_bytes >= bytes && s->live_pages >= pages);
+  s->free_cnt++;
+  s->live_bytes -= bytes;
+  s->live_pages -= pages;
+  live_bytes -= bytes;
+  live_pages -= pages;
+  intr_set_level (old_level);
+}
+
+/* Prints allocation statistics for each calling site, followed
+   by a list of the callsites in a form that the `backtrace'
+   utility accepts. */
+void
+memstat_print_stats (void)
+{
+  int64_t uptime;
+  size_t i;
+
+  if (!memstat_enabled)
+    return;
+
+  uptime = timer_ticks ();
+  if (uptime == 0)
+    uptime = 1;
+
+  printf ("Memstat: %zu bytes and %zu pages live, "
+          "peak %zu bytes and %zu pages\n",
+          live_bytes, live_pages, peak_bytes, peak_pages);
+  printf ("Memstat: %llu allocations, %llu/s average, %llu/s last second\n",
+          alloc_cnt, alloc_cnt * TIMER_FREQ / uptime, window_rate);
+
+  for (i = 1; i < SITE_CNT; i++)
+    {
+      const struct site *s = &sites[i];
+      if (s->alloc_cnt == 0)
+        continue;
+
+      if (i == SITE_OVERFLOW)
+        printf ("  (others)  ");
+      else
+        printf ("  %p:", s->caller);
+      printf (" %zu bytes, %zu pages live; peak %zu bytes, %zu pages;"
+              " %llu allocs, %llu frees, %llu/s\n",
+              s->live_bytes, s->live_pages, s->peak_bytes, s->peak_pages,
+              s->alloc_cnt, s->free_cnt, s->alloc_cnt * TIMER_FREQ / uptime);
+    }
+
+  printf ("Memstat callsites:");
+  for (i = 1; i < SITE_OVERFLOW; i++)
+    if (sites[i].alloc_cnt > 0)
+      printf (" %p", sites[i].caller);
+  printf (".\n");
+}
@@ -0,0 +1,30 @@
+#ifndef THREADS_MEMSTAT_H
+#define THREADS_MEMSTAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Memory allocation tracing.
+
+   When enabled, palloc() and malloc() tag every allocation with
+   the address of the code that requested it, and live byte and
+   page counts are kept per calling site.  The callsite addresses
+   can be turned into function names and line numbers with the
+   `backtrace' utility. */
+
+/* Identifies a calling site in the memstat table.
+   0 is never a valid site. */
+typedef uint16_t memstat_site_t;
+
+/* If false (default), allocations are not traced.
+   Controlled by kernel command-line option "-mtrace".  Must not
+   change after the page allocator is initialized. */
+extern bool memstat_enabled;
+
+memstat_site_t memstat_alloc (const void *caller, size_t bytes,
+                              size_t pages);
+void memstat_free (memstat_site_t, size_t bytes, size_t pages);
+void memstat_print_stats (void);
+
+#endif /* threads/memstat.h */
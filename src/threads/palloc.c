@@ -8,6 +8,9 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/loader.h"
+#include "threads/interrupt.h"
+#include "threads/memstat.h"
+#include "threads/shrinker.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 
@@ -23,7 +26,17 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Kernel caches can register shrinkers (see shrinker.h).  If
+   the kernel pool cannot satisfy a request, the shrinkers are
+   asked to free memory before the request fails, and the
+   background reclaim thread is woken as soon as the kernel pool
+   falls below its low watermark.
+
+   When allocation tracing is enabled, each pool also keeps an
+   array that records, for every page, the memstat site that
+   allocated it.  The array lives next to the pool's bitmap. */
 
 /* A memory pool. */
 struct pool
@@ -31,14 +44,25 @@ struct pool
     struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    memstat_site_t *sites;              /* Allocating site of each page. */
+    size_t free_cnt;                    /* Number of free pages. */
+    size_t low_water;                   /* Wake reclaim below this. */
+    size_t high_water;                  /* Reclaim up to this. */
   };
 
+/* Objects to ask the shrinkers for, per page requested, before
+   retrying a failed kernel pool allocation. */
+#define SHRINK_BATCH 8
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t scan_aligned (struct pool *, size_t page_cnt, size_t align);
+static void *get_multiple (enum palloc_flags, size_t page_cnt,
+                           size_t align, const void *caller);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -69,6 +93,42 @@ palloc_init (size_t user_page_limit)
    FLAGS, in which case the kernel panics. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
+{
+  return get_multiple (flags, page_cnt, 1, __builtin_return_address (0));
+}
+
+/* Like palloc_get_multiple(), but the first page returned is
+   aligned on a multiple of ALIGN pages in physical memory.
+   ALIGN must be a power of 2.  Used to obtain the 4 MB-aligned
+   memory behind a large page mapping. */
+void *
+palloc_get_multiple_aligned (enum palloc_flags flags, size_t page_cnt,
+                             size_t align)
+{
+  ASSERT (align != 0 && (align & (align - 1)) == 0);
+  return get_multiple (flags, page_cnt, align,
+                       __builtin_return_address (0));
+}
+
+/* Obtains a single free page and returns its kernel virtual
+   address.
+   If PAL_USER is set, the page is obtained from the user pool,
+   otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
+   then the page is filled with zeros.  If no pages are
+   available, returns a null pointer, unless PAL_ASSERT is set in
+   FLAGS, in which case the kernel panics. */
+void *
+palloc_get_page (enum palloc_flags flags) 
+{
+  return get_multiple (flags, 1, 1, __builtin_return_address (0));
+}
+
+/* Does the work of palloc_get_multiple() and
+   palloc_get_multiple_aligned(), attributing the allocation to
+   CALLER if allocation tracing is enabled. */
+static void *
+get_multiple (enum palloc_flags flags, size_t page_cnt, size_t align,
+              const void *caller)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
@@ -77,9 +137,21 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  for (;;)
+    {
+      lock_acquire (&pool->lock);
+      if (align > 1)
+        page_idx = scan_aligned (pool, page_cnt, align);
+      else
+        page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+      lock_release (&pool->lock);
+
+      /* Caches live in the kernel pool, so reclaiming from them
+         only helps kernel pool allocations. */
+      if (page_idx != BITMAP_ERROR || pool != &kernel_pool
+          || shrinker_shrink (page_cnt * SHRINK_BATCH) == 0)
+        break;
+    }
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
@@ -88,8 +160,22 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 
   if (pages != NULL) 
     {
+      enum intr_level old_level = intr_disable ();
+      pool->free_cnt -= page_cnt;
+      if (pool == &kernel_pool && pool->free_cnt < pool->low_water)
+        shrinker_wakeup ();
+      intr_set_level (old_level);
+
       if (flags & PAL_ZERO)
         memset (pages, 0, PGSIZE * page_cnt);
+      if (memstat_enabled)
+        {
+          memstat_site_t site = memstat_alloc (caller, 0, page_cnt);
+          size_t i;
+
+          for (i = 0; i < page_cnt; i++)
+            pool->sites[page_idx + i] = site;
+        }
     }
   else 
     {
@@ -100,17 +186,23 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   return pages;
 }
 
-/* Obtains a single free page and returns its kernel virtual
-   address.
-   If PAL_USER is set, the page is obtained from the user pool,
-   otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
-   then the page is filled with zeros.  If no pages are
-   available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
-void *
-palloc_get_page (enum palloc_flags flags) 
+/* Finds PAGE_CNT free pages in POOL whose first page is
+   aligned on a multiple of ALIGN pages, marks them used, and
+   returns the index of the first one.  Returns BITMAP_ERROR if
+   there is no such group.  POOL's lock must be held. */
+static size_t
+scan_aligned (struct pool *pool, size_t page_cnt, size_t align)
 {
-  return palloc_get_multiple (flags, 1);
+  size_t cnt = bitmap_size (pool->used_map);
+  size_t idx = (align - pg_no (pool->base) % align) % align;
+
+  for (; idx + page_cnt <= cnt; idx += align)
+    if (bitmap_none (pool->used_map, idx, page_cnt))
+      {
+        bitmap_set_multiple (pool->used_map, idx, page_cnt, true);
+        return idx;
+      }
+  return BITMAP_ERROR;
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
@@ -119,6 +211,7 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 {
   struct pool *pool;
   size_t page_idx;
+  enum intr_level old_level;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
@@ -138,7 +231,25 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 #endif
 
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+  if (memstat_enabled)
+    {
+      size_t i, run;
+
+      /* Credit each run of pages back to the site that
+         allocated it. */
+      for (i = 0; i < page_cnt; i += run)
+        {
+          memstat_site_t site = pool->sites[page_idx + i];
+          for (run = 1; i + run < page_cnt; run++)
+            if (pool->sites[page_idx + i + run] != site)
+              break;
+          memstat_free (site, 0, run);
+        }
+    }
+  old_level = intr_disable ();
   bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  pool->free_cnt += page_cnt;
+  intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -148,15 +259,27 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Returns true if the kernel pool is below its high watermark,
+   meaning that the background reclaim thread should keep
+   shrinking caches. */
+bool
+palloc_reclaim_needed (void)
+{
+  return kernel_pool.free_cnt < kernel_pool.high_water;
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
+  /* We'll put the pool's used_map at its base, followed by the
+     per-page site array if allocation tracing is enabled.
+     Calculate the space needed for them and subtract it from the
+     pool's size. */
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t sites_size = memstat_enabled ? page_cnt * sizeof *p->sites : 0;
+  size_t bm_pages = DIV_ROUND_UP (bm_size + sites_size, PGSIZE);
   if (bm_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
   page_cnt -= bm_pages;
@@ -165,8 +288,13 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
 
   /* Initialize the pool. */
   lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  p->sites = memstat_enabled ? (memstat_site_t *) ((uint8_t *) base + bm_size)
+                             : NULL;
   p->base = base + bm_pages * PGSIZE;
+  p->free_cnt = page_cnt;
+  p->low_water = page_cnt / 16;
+  p->high_water = page_cnt / 8;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -0,0 +1,173 @@
+#include "threads/shrinker.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Memory pressure shrinkers.
+
+   Kernel caches register a shrinker that can release some of
+   their objects.  When the kernel pool cannot satisfy an
+   allocation, palloc calls the shrinkers in registration order
+   ("direct reclaim") and retries.  To keep that from happening
+   in the first place, palloc also wakes a background reclaim
+   thread whenever the kernel pool falls below its low
+   watermark; that thread keeps shrinking caches until the pool
+   is back above its high watermark or the caches are empty.
+
+   Together these let caches be sized generously by default,
+   because the memory they hold is still available when someone
+   else needs it. */
+
+/* Number of objects to ask for per pass of the reclaim thread. */
+#define RECLAIM_BATCH 16
+
+/* Registered shrinkers, in the order they are called. */
+static struct list shrinker_list;
+
+/* Protects shrinker_list and serializes reclaim. */
+static struct lock shrinker_lock;
+
+/* Wakes up the reclaim thread. */
+static struct semaphore reclaim_sema;
+static bool reclaim_pending;
+static bool initialized;
+
+/* Statistics. */
+static long long direct_cnt;            /* Direct reclaim passes. */
+static long long wakeup_cnt;            /* Reclaim thread wakeups. */
+
+static thread_func reclaim_thread NO_RETURN;
+
+/* Initializes the shrinker registry.  Must be called before the
+   page allocator is initialized. */
+void
+shrinker_init (void)
+{
+  list_init (&shrinker_list);
+  lock_init (&shrinker_lock);
+  sema_init (&reclaim_sema, 0);
+  initialized = true;
+}
+
+/* Starts the background reclaim thread.  Must be called after
+   thread_start(). */
+void
+shrinker_start (void)
+{
+  thread_create ("reclaim", PRI_DEFAULT, reclaim_thread, NULL);
+}
+
+/* Adds S to the end of the list of shrinkers. */
+void
+shrinker_register (struct shrinker *s)
+{
+  ASSERT (s != NULL && s->count != NULL && s->scan != NULL);
+
+  lock_acquire (&shrinker_lock);
+  s->freed_cnt = 0;
+  list_push_back (&shrinker_list, &s->elem);
+  lock_release (&shrinker_lock);
+}
+
+/* Removes S from the list of shrinkers. */
+void
+shrinker_unregister (struct shrinker *s)
+{
+  lock_acquire (&shrinker_lock);
+  list_remove (&s->elem);
+  lock_release (&shrinker_lock);
+}
+
+/* Asks each shrinker, in order, to free objects until NR have
+   been freed in total or every shrinker has been tried.
+   Returns the number of objects freed.
+
+   Does nothing, returning 0, if called with interrupts off or
+   from a shrinker's own callback. */
+size_t
+shrinker_shrink (size_t nr)
+{
+  struct list_elem *e;
+  size_t freed = 0;
+
+  if (!initialized || intr_context () || intr_get_level () == INTR_OFF
+      || lock_held_by_current_thread (&shrinker_lock))
+    return 0;
+
+  lock_acquire (&shrinker_lock);
+  for (e = list_begin (&shrinker_list); e != list_end (&shrinker_list)
+         && freed < nr; e = list_next (e))
+    {
+      struct shrinker *s = list_entry (e, struct shrinker, elem);
+      if (s->count () > 0)
+        {
+          size_t cnt = s->scan (nr - freed);
+          s->freed_cnt += cnt;
+          freed += cnt;
+        }
+    }
+  direct_cnt++;
+  lock_release (&shrinker_lock);
+
+  return freed;
+}
+
+/* Wakes the background reclaim thread.  May be called with
+   interrupts off. */
+void
+shrinker_wakeup (void)
+{
+  enum intr_level old_level;
+
+  if (!initialized)
+    return;
+
+  old_level = intr_disable ();
+  if (!reclaim_pending)
+    {
+      reclaim_pending = true;
+      sema_up (&reclaim_sema);
+    }
+  intr_set_level (old_level);
+}
+
+/* Prints shrinker statistics. */
+void
+shrinker_print_stats (void)
+{
+  struct list_elem *e;
+
+  printf ("Shrinker: %lld reclaim passes, %lld background wakeups\n",
+          direct_cnt, wakeup_cnt);
+  for (e = list_begin (&shrinker_list); e != list_end (&shrinker_list);
+       e = list_next (e))
+    {
+      struct shrinker *s = list_entry (e, struct shrinker, elem);
+      printf ("  %s: %llu objects freed\n", s->name, s->freed_cnt);
+    }
+}
+
+/* Background reclaim thread.  Shrinks caches whenever the
+   kernel pool drops below its low watermark, until it is back
+   above its high watermark. */
+static void
+reclaim_thread (void *aux UNUSED)
+{
+  for (;;)
+    {
+      sema_down (&reclaim_sema);
+      wakeup_cnt++;
+
+      while (palloc_reclaim_needed ())
+        {
+          if (shrinker_shrink (RECLAIM_BATCH) == 0)
+            break;
+          thread_yield ();
+        }
+
+      reclaim_pending = false;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef THREADS_SHRINKER_H
+#define THREADS_SHRINKER_H
+
+#include <list.h>
+#include <stddef.h>
+
+/* Returns the number of objects that a cache could free. */
+typedef size_t shrinker_count_func (void);
+
+/* Frees up to NR objects from a cache and returns the number
+   actually freed.  May be called by any thread that is trying
+   to allocate memory, possibly while it holds locks of its own,
+   so it must not block on a lock that an allocating thread
+   might hold: use lock_try_acquire() and return 0 on failure. */
+typedef size_t shrinker_scan_func (size_t nr);
+
+/* A cache that can give memory back when the kernel pool runs
+   short. */
+struct shrinker
+  {
+    const char *name;                   /* Name (for statistics). */
+    shrinker_count_func *count;         /* Counts freeable objects. */
+    shrinker_scan_func *scan;           /* Frees objects. */
+    unsigned long long freed_cnt;       /* Objects freed so far. */
+    struct list_elem elem;              /* Element in shrinker list. */
+  };
+
+void shrinker_init (void);
+void shrinker_start (void);
+void shrinker_register (struct shrinker *);
+void shrinker_unregister (struct shrinker *);
+size_t shrinker_shrink (size_t nr);
+void shrinker_wakeup (void);
+void shrinker_print_stats (void);
+
+#endif /* threads/shrinker.h */
@@ -8,6 +8,7 @@
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/shrinker.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -39,6 +40,18 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
+/* Pages of dead threads, kept for reuse by thread_create().
+   Each cached page begins with the list element that links it
+   into the cache.  Accessed only with interrupts off, because
+   dead threads are added from thread_schedule_tail(). */
+#define THREAD_CACHE_MAX 64
+static struct list thread_cache;
+static size_t thread_cache_cnt;
+static shrinker_count_func thread_cache_count;
+static shrinker_scan_func thread_cache_scan;
+static struct shrinker thread_cache_shrinker =
+  {"thread cache", thread_cache_count, thread_cache_scan, 0, {NULL, NULL}};
+
 /* Stack frame for kernel_thread(). */
 struct kernel_thread_frame 
   {
@@ -74,6 +87,8 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static struct thread *thread_cache_get (void);
+static void thread_cache_put (struct thread *);
 
 static void insert_thread_ordered (struct thread *t);
 static void update_priority (struct thread *t, int new_priority);
@@ -109,6 +124,7 @@ thread_init (void)
   lock_init (&tid_lock);
   list_init (&ready_list);
   list_init (&all_list);
+  list_init (&thread_cache);
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
@@ -136,6 +152,7 @@ thread_start (void)
   struct semaphore idle_started;
   sema_init (&idle_started, 0);
   thread_create ("idle", PRI_MIN, idle, &idle_started);
+  shrinker_register (&thread_cache_shrinker);
 
   /* Start preemptive thread scheduling. */
   intr_enable ();
@@ -223,7 +240,7 @@ thread_create (const char *name, int priority,
   ASSERT (function != NULL);
 
   /* Allocate thread. */
-  t = palloc_get_page (PAL_ZERO);
+  t = thread_cache_get ();
   if (t == NULL)
     return TID_ERROR;
 
@@ -918,6 +935,15 @@ init_thread (struct thread *t, const char *name, int priority)
   t->stack = (uint8_t *) t + PGSIZE;
   t->priority = priority;
   t->magic = THREAD_MAGIC;
+#ifdef USERPROG
+  fd_table_init (&t->fds);
+  t->ioring = NULL;
+  t->exit_status = -1;
+  list_init (&t->children);
+#endif
+#ifdef VM
+  list_init (&t->mappings);
+#endif
   list_push_back (&all_list, &t->allelem);
 }
 
@@ -990,7 +1016,7 @@ thread_schedule_tail (struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) 
     {
       ASSERT (prev != cur);
-      palloc_free_page (prev);
+      thread_cache_put (prev);
     }
 }
 
@@ -1031,6 +1057,78 @@ allocate_tid (void)
   return tid;
 }
 
+/* Returns a zeroed page for a new thread, reusing the page of a
+   dead thread if one is cached.  Returns a null pointer if no
+   memory is available. */
+static struct thread *
+thread_cache_get (void)
+{
+  struct thread *t = NULL;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  if (!list_empty (&thread_cache))
+    {
+      t = (struct thread *) list_pop_front (&thread_cache);
+      thread_cache_cnt--;
+    }
+  intr_set_level (old_level);
+
+  if (t != NULL)
+    memset (t, 0, PGSIZE);
+  else
+    t = palloc_get_page (PAL_ZERO);
+  return t;
+}
+
+/* Caches the page of dead thread T for reuse, or frees it if the
+   cache is full.  Must be called with interrupts off. */
+static void
+thread_cache_put (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (thread_cache_cnt < THREAD_CACHE_MAX)
+    {
+      list_push_front (&thread_cache, (struct list_elem *) t);
+      thread_cache_cnt++;
+    }
+  else
+    palloc_free_page (t);
+}
+
+/* Returns the number of pages in the thread cache. */
+static size_t
+thread_cache_count (void)
+{
+  return thread_cache_cnt;
+}
+
+/* Frees up to NR pages from the thread cache.  Returns the
+   number freed. */
+static size_t
+thread_cache_scan (size_t nr)
+{
+  size_t freed;
+
+  for (freed = 0; freed < nr; freed++)
+    {
+      enum intr_level old_level = intr_disable ();
+      struct list_elem *e = NULL;
+      if (!list_empty (&thread_cache))
+        {
+          e = list_pop_back (&thread_cache);
+          thread_cache_cnt--;
+        }
+      intr_set_level (old_level);
+
+      if (e == NULL)
+        break;
+      palloc_free_page (e);
+    }
+  return freed;
+}
+
 /* Offset of `stack' member within `struct thread'.
    Used by switch.S, which can't figure it out on its own. */
 uint32_t thread_stack_ofs = offsetof (struct thread, stack);
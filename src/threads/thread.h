@@ -2,9 +2,13 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <faultstat.h>
 #include <list.h>
 #include <stdint.h>
 #include "threads/fixed_point.h"
+#ifdef USERPROG
+#include "userprog/fdtable.h"
+#endif
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -108,6 +112,31 @@ struct thread
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
+    struct fd_table fds;                /* Open files. */
+    int exit_status;                    /* Status passed to exit(). */
+    struct wait_status *wait_status;    /* This process's status. */
+    struct list children;               /* Children's wait_status. */
+    struct ioring_ctx *ioring;          /* Submission/completion rings. */
+
+    /* Owned by userprog/exception.c. */
+    uint64_t fault_cnt[FAULT_CLASS_CNT];     /* Page faults by class. */
+    uint64_t fault_cycles[FAULT_CLASS_CNT];  /* ...and their cycles. */
+#endif
+#ifdef VM
+    struct hash *pages;                 /* Supplemental page table. */
+    struct file *exec_file;             /* Executable, for demand paging. */
+    struct list mappings;               /* Memory-mapped files. */
+    int next_mapid;                     /* Mapping identifier to use next. */
+    void *user_esp;                     /* User %esp on entry to kernel. */
+    uint8_t *stack_bottom;              /* Lowest user stack page. */
+    unsigned stack_ahead;               /* Stack pages to map ahead. */
+
+    /* Owned by vm/frame.c. */
+    size_t rss;                         /* Pages in frames. */
+    size_t rss_allot;                   /* Frames allotted, 0 if none. */
+    bool rss_over;                      /* RSS exceeds allotment? */
+    int64_t pff_start;                  /* Start of PFF interval. */
+    unsigned pff_faults;                /* Faults in PFF interval. */
 #endif
 
     /* Owned by thread.c. */
@@ -0,0 +1,161 @@
+#include "userprog/elfcache.h"
+#include <debug.h>
+#include <stdio.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/shrinker.h"
+#include "threads/synch.h"
+#include "userprog/syscall.h"
+#ifdef VM
+#include "vm/frame.h"
+#endif
+
+/* Cache of parsed executables.
+
+   load() reads and checks an executable's ELF header and program
+   headers every time a program starts.  A system that runs the
+   same few programs over and over repeats that work for nothing,
+   so load() keeps the result here, keyed by the executable's
+   inode.  Each entry holds a reference to its inode, which keeps
+   the inode in memory, so that opening the executable again does
+   not read it from disk either.  With VM, segments are read in
+   only as pages are touched, so starting a cached program reads
+   almost nothing from the disk.
+
+   An entry is good only as long as the inode's version matches
+   the one recorded when the entry was made.  Writing to the file
+   or removing it changes the version, and the next lookup drops
+   every entry gone stale this way, which also lets the blocks of
+   removed executables be freed.  The cache holds at most
+   ELF_CACHE_MAX entries, discarding the least recently used, and
+   gives them up to the shrinker when memory runs short.
+
+   Entries are protected by filesys_lock, which load() holds. */
+
+/* Maximum number of cached executables. */
+#define ELF_CACHE_MAX 16
+
+/* Cached images, most recently used first. */
+static struct list cache;
+static size_t cache_cnt;
+
+/* Statistics. */
+static long long hit_cnt;               /* Lookups that found an entry. */
+static long long miss_cnt;              /* Lookups that did not. */
+static long long stale_cnt;             /* Entries dropped after writes. */
+
+static shrinker_count_func elf_cache_count;
+static shrinker_scan_func elf_cache_scan;
+static struct shrinker elf_cache_shrinker =
+  {"ELF cache", elf_cache_count, elf_cache_scan, 0, {NULL, NULL}};
+
+static void evict (struct elf_image *);
+
+/* Initializes the cache. */
+void
+elf_cache_init (void)
+{
+  list_init (&cache);
+  shrinker_register (&elf_cache_shrinker);
+}
+
+/* Returns the cached image of the executable open as FILE, or a
+   null pointer if there is none.  Also drops stale entries.  The
+   image stays valid until the caller releases filesys_lock. */
+struct elf_image *
+elf_cache_lookup (struct file *file)
+{
+  struct inode *inode = file_get_inode (file);
+  struct elf_image *found = NULL;
+  struct list_elem *e, *next;
+
+  ASSERT (lock_held_by_current_thread (&filesys_lock));
+
+  for (e = list_begin (&cache); e != list_end (&cache); e = next)
+    {
+      struct elf_image *image = list_entry (e, struct elf_image, elem);
+      next = list_next (e);
+      if (image->version != inode_version (image->inode))
+        {
+          stale_cnt++;
+          evict (image);
+        }
+      else if (image->inode == inode)
+        found = image;
+    }
+
+  if (found != NULL)
+    {
+      hit_cnt++;
+      list_remove (&found->elem);
+      list_push_front (&cache, &found->elem);
+    }
+  else
+    miss_cnt++;
+  return found;
+}
+
+/* Adds IMAGE, parsed from the executable open as FILE, to the
+   cache, which takes ownership of it.  IMAGE stays valid until
+   the caller releases filesys_lock. */
+void
+elf_cache_insert (struct file *file, struct elf_image *image)
+{
+  struct inode *inode = file_get_inode (file);
+
+  ASSERT (lock_held_by_current_thread (&filesys_lock));
+
+  image->inode = inode_reopen (inode);
+  image->version = inode_version (inode);
+  list_push_front (&cache, &image->elem);
+  if (++cache_cnt > ELF_CACHE_MAX)
+    evict (list_entry (list_back (&cache), struct elf_image, elem));
+}
+
+/* Prints cache statistics. */
+void
+elf_cache_print_stats (void)
+{
+  printf ("ELF cache: %lld hits, %lld misses, %lld invalidated\n",
+          hit_cnt, miss_cnt, stale_cnt);
+}
+
+/* Returns the number of cached images. */
+static size_t
+elf_cache_count (void)
+{
+  return cache_cnt;
+}
+
+/* Frees up to NR of the least recently used images.  Returns
+   the number freed.  A thread that already holds filesys_lock
+   may be using an image, and closing an inode may write to the
+   free map, which a thread that holds frame_lock may not do (see
+   frame_write_file()), so such threads free none. */
+static size_t
+elf_cache_scan (size_t nr)
+{
+  size_t cnt;
+
+  if (lock_held_by_current_thread (&filesys_lock)
+#ifdef VM
+      || lock_held_by_current_thread (&frame_lock)
+#endif
+      || !lock_try_acquire (&filesys_lock))
+    return 0;
+  for (cnt = 0; cnt < nr && !list_empty (&cache); cnt++)
+    evict (list_entry (list_back (&cache), struct elf_image, elem));
+  lock_release (&filesys_lock);
+  return cnt;
+}
+
+/* Removes IMAGE from the cache and frees it. */
+static void
+evict (struct elf_image *image)
+{
+  list_remove (&image->elem);
+  cache_cnt--;
+  inode_close (image->inode);
+  free (image);
+}
@@ -0,0 +1,39 @@
+#ifndef USERPROG_ELFCACHE_H
+#define USERPROG_ELFCACHE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct file;
+
+/* A loadable segment of an executable, already checked by
+   load(). */
+struct elf_segment
+  {
+    uint32_t file_page;         /* Offset in file, page-aligned. */
+    uint32_t mem_page;          /* User virtual address, page-aligned. */
+    uint32_t read_bytes;        /* Bytes to read from the file. */
+    uint32_t zero_bytes;        /* Bytes to zero after them. */
+    bool writable;              /* Writable by the user? */
+  };
+
+/* What load() needs to know about an executable, besides the
+   contents of its segments. */
+struct elf_image
+  {
+    struct list_elem elem;      /* Element in cache. */
+    struct inode *inode;        /* Executable, if cached. */
+    unsigned version;           /* inode_version() when parsed. */
+    uint32_t entry;             /* Entry point. */
+    size_t seg_cnt;             /* Number of segments. */
+    struct elf_segment segs[];  /* Loadable segments. */
+  };
+
+void elf_cache_init (void);
+struct elf_image *elf_cache_lookup (struct file *);
+void elf_cache_insert (struct file *, struct elf_image *);
+void elf_cache_print_stats (void);
+
+#endif /* userprog/elfcache.h */
@@ -1,15 +1,28 @@
 #include "userprog/exception.h"
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
-/* Number of page faults processed. */
-static long long page_fault_cnt;
+/* Page faults processed, by class, with their latencies. */
+static struct fault_stats fault_stats;
+
+/* Names of fault classes, for printing statistics. */
+static const char *fault_class_names[FAULT_CLASS_CNT] =
+  {"minor", "zero-fill", "file", "swap-in", "copy-on-write",
+   "stack growth", "invalid"};
 
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
+static void record_fault (enum fault_class, uint64_t start);
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -60,11 +73,55 @@ exception_init (void)
   intr_register_int (14, 0, INTR_OFF, page_fault, "#PF Page-Fault Exception");
 }
 
-/* Prints exception statistics. */
+/* Prints exception statistics: for each class of page fault,
+   the number of faults, their average latency, and the nonempty
+   buckets of their latency histogram, each shown as the lowest
+   power of 2 it covers, in CPU cycles. */
 void
 exception_print_stats (void) 
 {
-  printf ("Exception: %lld page faults\n", page_fault_cnt);
+  uint64_t total = 0;
+  int c, b;
+
+  for (c = 0; c < FAULT_CLASS_CNT; c++)
+    total += fault_stats.count[c];
+  printf ("Exception: %"PRIu64" page faults\n", total);
+
+  for (c = 0; c < FAULT_CLASS_CNT; c++)
+    {
+      uint64_t cnt = fault_stats.count[c];
+      if (cnt == 0)
+        continue;
+
+      printf ("  %s: %"PRIu64" faults, %"PRIu64" cycles each on average;",
+              fault_class_names[c], cnt, fault_stats.cycles[c] / cnt);
+      for (b = 0; b < FAULT_HIST_BUCKETS; b++)
+        if (fault_stats.hist[c][b] != 0)
+          printf (" 2^%d:%"PRIu64, b == 0 ? 0 : b + FAULT_HIST_SHIFT,
+                  fault_stats.hist[c][b]);
+      printf ("\n");
+    }
+}
+
+/* Copies page fault statistics into *STATS: those of the current
+   process, without histograms, if SELF is true, otherwise those
+   of the whole system. */
+void
+exception_get_fault_stats (bool self, struct fault_stats *stats)
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (self)
+    {
+      struct thread *t = thread_current ();
+
+      memset (stats, 0, sizeof *stats);
+      memcpy (stats->count, t->fault_cnt, sizeof stats->count);
+      memcpy (stats->cycles, t->fault_cycles, sizeof stats->cycles);
+    }
+  else
+    *stats = fault_stats;
+  intr_set_level (old_level);
 }
 
 /* Handler for an exception (probably) caused by a user process. */
@@ -126,6 +183,10 @@ page_fault (struct intr_frame *f)
   bool write;        /* True: access was write, false: access was read. */
   bool user;         /* True: access by user, false: access by kernel. */
   void *fault_addr;  /* Fault address. */
+  uint64_t start;    /* Time stamp counter at entry. */
+#ifdef VM
+  enum fault_class class;
+#endif
 
   /* Obtain faulting address, the virtual address that was
      accessed to cause the fault.  It may point to code or to
@@ -135,19 +196,61 @@ page_fault (struct intr_frame *f)
      [IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
      (#PF)". */
   asm ("movl %%cr2, %0" : "=r" (fault_addr));
+  start = cpu_rdtsc ();
 
   /* Turn interrupts back on (they were only off so that we could
      be assured of reading CR2 before it changed). */
   intr_enable ();
 
-  /* Count page faults. */
-  page_fault_cnt++;
-
   /* Determine cause. */
   not_present = (f->error_code & PF_P) == 0;
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+#ifdef VM
+  /* A page that has not been loaded yet, or a stack that needs
+     to grow?  This also covers the kernel touching user memory
+     on behalf of a system call, in which case the user stack
+     pointer is the one saved on entry to the system call. */
+  if (not_present)
+    {
+      if (page_in (fault_addr, write, &class))
+        {
+          record_fault (class, start);
+          return;
+        }
+      if (page_grow_stack (fault_addr,
+                           user ? f->esp : thread_current ()->user_esp))
+        {
+          record_fault (FAULT_STACK, start);
+          return;
+        }
+    }
+
+  /* A write to a page shared copy-on-write after fork()? */
+  if (!not_present && write && page_copy_on_write (fault_addr))
+    {
+      record_fault (FAULT_COW, start);
+      return;
+    }
+#endif
+  record_fault (FAULT_INVALID, start);
+
+  /* A kernel access to a user address on behalf of a system
+     call.  A bad address passed to get_user() or put_user() in
+     userprog/syscall.c makes the access fail.  Any other such
+     fault kills the process. */
+  if (!user && is_user_vaddr (fault_addr))
+    {
+      if (syscall_fixup (f))
+        return;
+      printf ("Page fault at %p: %s error %s page in system call.\n",
+              fault_addr,
+              not_present ? "not present" : "rights violation",
+              write ? "writing" : "reading");
+      syscall_abort ();
+    }
+
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
@@ -159,3 +262,27 @@ page_fault (struct intr_frame *f)
   kill (f);
 }
 
+/* Counts a page fault of class CLASS, handled since the time
+   stamp counter read START, for the system and for the current
+   process. */
+static void
+record_fault (enum fault_class class, uint64_t start)
+{
+  uint64_t cycles = cpu_rdtsc () - start;
+  struct thread *t = thread_current ();
+  enum intr_level old_level;
+  int bucket = FAULT_HIST_SHIFT + 1;
+
+  while (bucket < FAULT_HIST_SHIFT + FAULT_HIST_BUCKETS
+         && cycles >> bucket != 0)
+    bucket++;
+  bucket -= FAULT_HIST_SHIFT + 1;
+
+  old_level = intr_disable ();
+  fault_stats.count[class]++;
+  fault_stats.cycles[class] += cycles;
+  fault_stats.hist[class][bucket]++;
+  t->fault_cnt[class]++;
+  t->fault_cycles[class] += cycles;
+  intr_set_level (old_level);
+}
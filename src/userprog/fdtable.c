@@ -0,0 +1,204 @@
+#include "userprog/fdtable.h"
+#include <debug.h>
+#include <limits.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+
+/* File descriptor tables.
+
+   A process's file descriptors index an array of slots, so
+   looking one up takes constant time however many files the
+   process has open.  The array starts out empty and doubles in
+   size whenever it fills up.  A bitmap of slots in use, one bit
+   per slot, finds the lowest free descriptor for open() a word
+   at a time, starting from FIRST_FREE, below which every slot is
+   known to be in use.  Slots 0 and 1 stand for the console and
+   are always in use, with no file.
+
+   A slot refers to an open file with a reference of its own (see
+   file_dup()), so that several slots, in one process or in
+   several, can share one file and its position.  fork() copies
+   every slot this way.  exec() starts the new process with only
+   the slots that are not marked close-on-exec.  Pintos has
+   always started programs with no files open, so open() marks
+   new descriptors close-on-exec; a process must clear the flag
+   with set_cloexec() to pass a descriptor on.
+
+   A process's table may be used by other threads on its behalf
+   (see userprog/ioring.c), so every function here must be called
+   with filesys_lock held. */
+
+/* A slot in a file descriptor table. */
+struct fd_slot
+  {
+    struct file *file;          /* Open file, or null. */
+    bool cloexec;               /* Close on exec? */
+  };
+
+/* Bits per word of the bitmap. */
+#define WORD_BITS (sizeof (uint32_t) * CHAR_BIT)
+
+/* Smallest table allocated. */
+#define MIN_CAPACITY 32
+
+/* Descriptors reserved for the console. */
+#define RESERVED_FDS 2
+
+static bool grow (struct fd_table *, int capacity);
+
+/* Initializes T as an empty table. */
+void
+fd_table_init (struct fd_table *t)
+{
+  t->slots = NULL;
+  t->used = NULL;
+  t->capacity = 0;
+  t->first_free = RESERVED_FDS;
+}
+
+/* Fills DST, an empty table, with new references to the files
+   in SRC, at the same descriptors.  If EXEC is true, leaves out
+   descriptors marked close-on-exec, as for a program started
+   with exec().  Returns true if successful, false if memory
+   allocation fails, in which case DST is left empty. */
+bool
+fd_table_copy (struct fd_table *dst, const struct fd_table *src, bool exec)
+{
+  int fd;
+
+  ASSERT (dst->capacity == 0);
+
+  if (src->capacity == 0)
+    return true;
+  if (!grow (dst, src->capacity))
+    return false;
+  for (fd = RESERVED_FDS; fd < src->capacity; fd++)
+    {
+      const struct fd_slot *s = &src->slots[fd];
+      if (s->file != NULL && !(exec && s->cloexec))
+        {
+          dst->slots[fd].file = file_dup (s->file);
+          dst->slots[fd].cloexec = s->cloexec;
+          dst->used[fd / WORD_BITS] |= 1u << fd % WORD_BITS;
+        }
+    }
+  return true;
+}
+
+/* Closes every descriptor in T and frees its memory. */
+void
+fd_table_destroy (struct fd_table *t)
+{
+  int fd;
+
+  for (fd = RESERVED_FDS; fd < t->capacity; fd++)
+    file_close (t->slots[fd].file);
+  free (t->slots);
+  free (t->used);
+  fd_table_init (t);
+}
+
+/* Adds FILE to T at the lowest free descriptor, marked
+   close-on-exec if CLOEXEC is true, and returns the descriptor.
+   T takes over the caller's reference to FILE.  Returns -1 if
+   memory allocation fails. */
+int
+fd_table_add (struct fd_table *t, struct file *file, bool cloexec)
+{
+  int word_cnt = t->capacity / WORD_BITS;
+  int fd = -1;
+  int i;
+
+  ASSERT (file != NULL);
+
+  for (i = t->first_free / WORD_BITS; i < word_cnt; i++)
+    if (t->used[i] != UINT32_MAX)
+      {
+        fd = i * WORD_BITS + __builtin_ctz (~t->used[i]);
+        break;
+      }
+  if (fd < 0)
+    {
+      /* Every slot is in use, so the first new one is free. */
+      fd = t->capacity > 0 ? t->capacity : RESERVED_FDS;
+      if (t->capacity > INT_MAX / 2
+          || !grow (t, t->capacity > 0 ? t->capacity * 2 : MIN_CAPACITY))
+        return -1;
+    }
+
+  t->slots[fd].file = file;
+  t->slots[fd].cloexec = cloexec;
+  t->used[fd / WORD_BITS] |= 1u << fd % WORD_BITS;
+  t->first_free = fd + 1;
+  return fd;
+}
+
+/* Returns the file open in T as descriptor FD, or a null pointer
+   if there is none. */
+struct file *
+fd_table_get (const struct fd_table *t, int fd)
+{
+  return fd >= RESERVED_FDS && fd < t->capacity ? t->slots[fd].file : NULL;
+}
+
+/* Closes descriptor FD in T.  Returns true if successful, false
+   if FD is not open. */
+bool
+fd_table_close (struct fd_table *t, int fd)
+{
+  struct file *file = fd_table_get (t, fd);
+
+  if (file == NULL)
+    return false;
+  file_close (file);
+  t->slots[fd].file = NULL;
+  t->used[fd / WORD_BITS] &= ~(1u << fd % WORD_BITS);
+  if (fd < t->first_free)
+    t->first_free = fd;
+  return true;
+}
+
+/* Marks descriptor FD in T close-on-exec if CLOEXEC is true,
+   or not if it is false.  Returns true if successful, false if
+   FD is not open. */
+bool
+fd_table_set_cloexec (struct fd_table *t, int fd, bool cloexec)
+{
+  if (fd_table_get (t, fd) == NULL)
+    return false;
+  t->slots[fd].cloexec = cloexec;
+  return true;
+}
+
+/* Enlarges T to CAPACITY slots, a multiple of WORD_BITS.
+   Returns true if successful, false if memory allocation
+   fails. */
+static bool
+grow (struct fd_table *t, int capacity)
+{
+  int old_words = t->capacity / WORD_BITS;
+  int new_words = capacity / WORD_BITS;
+  struct fd_slot *slots;
+  uint32_t *used;
+
+  ASSERT (capacity % WORD_BITS == 0);
+  ASSERT (capacity > t->capacity);
+
+  slots = realloc (t->slots, capacity * sizeof *slots);
+  if (slots == NULL)
+    return false;
+  t->slots = slots;
+  used = realloc (t->used, new_words * sizeof *used);
+  if (used == NULL)
+    return false;
+  t->used = used;
+
+  memset (slots + t->capacity, 0,
+          (capacity - t->capacity) * sizeof *slots);
+  memset (used + old_words, 0, (new_words - old_words) * sizeof *used);
+  if (t->capacity == 0)
+    used[0] = (1u << RESERVED_FDS) - 1;
+  t->capacity = capacity;
+  return true;
+}
@@ -0,0 +1,27 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct file;
+
+/* A process's file descriptor table.  See fdtable.c. */
+struct fd_table
+  {
+    struct fd_slot *slots;      /* Indexed by file descriptor. */
+    uint32_t *used;             /* Bitmap of slots in use. */
+    int capacity;               /* Number of slots. */
+    int first_free;             /* No slot below this is free. */
+  };
+
+void fd_table_init (struct fd_table *);
+bool fd_table_copy (struct fd_table *dst, const struct fd_table *src,
+                    bool exec);
+void fd_table_destroy (struct fd_table *);
+int fd_table_add (struct fd_table *, struct file *, bool cloexec);
+struct file *fd_table_get (const struct fd_table *, int fd);
+bool fd_table_close (struct fd_table *, int fd);
+bool fd_table_set_cloexec (struct fd_table *, int fd, bool cloexec);
+
+#endif /* userprog/fdtable.h */
@@ -0,0 +1,498 @@
+#include "userprog/ioring.h"
+#include <debug.h>
+#include <ioring.h>
+#include <iovec.h>
+#include <list.h>
+#include <stdio.h>
+#include "filesys/directory.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "userprog/syscall.h"
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#endif
+
+/* Submission and completion rings.
+
+   A process that issues many small file system operations pays
+   for a trap into the kernel on each one.  With ioring_setup(),
+   it maps a page of rings (see lib/ioring.h) that it shares with
+   the kernel.  It queues any number of operations in the
+   submission ring and hands them all over with one
+   ioring_enter() call, then picks up their results from the
+   completion ring, which the kernel fills in without a trap.
+
+   ioring_enter() copies each submission into a request and
+   makes it independent of the submitting thread's address
+   space: a file name is copied into the request, and each page
+   of a buffer is pinned in memory and described by its kernel
+   address.  Pool threads then carry out the requests, in any
+   order, each one under filesys_lock like any system call, on
+   the submitter's file descriptor table, and post completions.
+   The submitter may go on running in the meantime, or wait in
+   ioring_enter() for a given number of completions.  fork()
+   waits for every request in flight before it copies the
+   address space.
+
+   ioring_enter() accepts no more submissions than the completion
+   ring has room for, counting requests still in flight, so that
+   a completion never overwrites one that the process has not
+   read.  A process that exits waits for its requests to finish
+   before its file descriptors are closed and its memory freed.
+
+   The file system has no buffer cache, so every write reaches
+   the disk before it completes, and fsync only checks that its
+   file descriptor is open. */
+
+/* Number of pool threads.
+   Controlled by kernel command-line option "-ioring". */
+size_t ioring_worker_cnt = 2;
+
+/* Most pages that a read or write buffer can span. */
+#define BUF_PAGES (IORING_MAX_LEN / PGSIZE + 1)
+
+/* A process's rings. */
+struct ioring_ctx
+  {
+    struct thread *owner;       /* Process that set up the rings. */
+    struct ioring *ring;        /* Kernel address of shared page. */
+    void *upage;                /* User address of shared page. */
+    uint32_t sq_head;           /* Next submission to consume. */
+
+    /* Protected by LOCK. */
+    struct lock lock;
+    struct condition done;      /* Signaled on each completion. */
+    uint32_t cq_tail;           /* Next completion to post. */
+    unsigned inflight;          /* Requests not yet completed. */
+  };
+
+/* A submitted operation. */
+struct ioring_req
+  {
+    struct list_elem elem;      /* Element in request queue. */
+    struct ioring_ctx *ctx;     /* Rings submitted to. */
+    struct ioring_sqe sqe;      /* Copy of submission. */
+    struct iovec iov[BUF_PAGES]; /* Buffer, one element per page. */
+    int iov_cnt;                /* Number of elements in IOV. */
+#ifdef VM
+    struct frame *frames[BUF_PAGES]; /* Pinned frame for each page. */
+#endif
+    char name[NAME_MAX + 1];    /* File name, for open. */
+  };
+
+/* Requests waiting for a pool thread. */
+static struct list queue;
+static struct lock queue_lock;
+static struct condition queue_nonempty;
+
+/* Statistics. */
+static long long enter_cnt;             /* Calls to ioring_enter(). */
+static long long submit_cnt;            /* Operations submitted. */
+static long long fail_cnt;              /* ...rejected on submission. */
+static long long wait_cnt;              /* Waits for completions. */
+
+static thread_func worker NO_RETURN;
+static bool prepare (struct ioring_req *);
+static int execute (struct ioring_req *);
+static void complete (struct ioring_ctx *, struct ioring_req *,
+                      uint32_t user_data, int res);
+static bool pin_buffer (struct ioring_req *, bool write);
+static void unpin_buffer (struct ioring_req *);
+
+/* Initializes the request queue and starts the pool threads. */
+void
+ioring_init (void)
+{
+  size_t i;
+
+  list_init (&queue);
+  lock_init (&queue_lock);
+  cond_init (&queue_nonempty);
+  for (i = 0; i < ioring_worker_cnt; i++)
+    {
+      char name[24];
+
+      snprintf (name, sizeof name, "ioring %zu", i);
+      thread_create (name, PRI_DEFAULT, worker, NULL);
+    }
+}
+
+/* Maps a new, empty pair of rings into the current process at
+   UPAGE, which must be a page-aligned user address that is not
+   in use.  Returns UPAGE if successful, a null pointer if UPAGE
+   is unsuitable, if the process already has rings, or if memory
+   allocation fails. */
+void *
+ioring_setup (void *upage)
+{
+  struct thread *t = thread_current ();
+  struct ioring_ctx *ctx;
+  void *kpage;
+
+  if (t->ioring != NULL || ioring_worker_cnt == 0 || upage == NULL
+      || pg_ofs (upage) != 0 || !is_user_vaddr (upage)
+      || pagedir_get_page (t->pagedir, upage) != NULL)
+    return NULL;
+#ifdef VM
+  /* Stay clear of the region that the stack may grow into,
+     which would try to map the page again. */
+  if (page_lookup (t->pages, upage) != NULL
+      || (uint8_t *) upage >= (uint8_t *) PHYS_BASE - stack_max_pages * PGSIZE)
+    return NULL;
+#endif
+
+  ctx = malloc (sizeof *ctx);
+  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+  if (ctx == NULL || kpage == NULL
+      || !pagedir_set_page (t->pagedir, upage, kpage, true))
+    {
+      palloc_free_page (kpage);
+      free (ctx);
+      return NULL;
+    }
+
+  ctx->owner = t;
+  ctx->ring = kpage;
+  ctx->upage = upage;
+  ctx->sq_head = 0;
+  lock_init (&ctx->lock);
+  cond_init (&ctx->done);
+  ctx->cq_tail = 0;
+  ctx->inflight = 0;
+  t->ioring = ctx;
+  return upage;
+}
+
+/* Submits up to TO_SUBMIT operations from the current process's
+   submission ring, then, if MIN_COMPLETE is nonzero, waits until
+   at least MIN_COMPLETE completions are waiting to be read or
+   nothing is in flight.  Returns the number of operations
+   submitted, or -1 if the process has no rings or has corrupted
+   their indexes. */
+int
+ioring_enter (unsigned to_submit, unsigned min_complete)
+{
+  struct ioring_ctx *ctx = thread_current ()->ioring;
+  struct ioring *ring;
+  struct list batch;
+  uint32_t sq_avail, cq_used, cq_room;
+  unsigned cnt, i;
+
+  if (ctx == NULL)
+    return -1;
+  ring = ctx->ring;
+
+  /* Reserve completion slots for the submissions. */
+  lock_acquire (&ctx->lock);
+  sq_avail = ring->sq_tail - ctx->sq_head;
+  cq_used = ctx->cq_tail - ring->cq_head;
+  if (sq_avail > IORING_SQ_ENTRIES || cq_used > IORING_CQ_ENTRIES)
+    {
+      lock_release (&ctx->lock);
+      return -1;
+    }
+  cq_room = (cq_used + ctx->inflight < IORING_CQ_ENTRIES
+             ? IORING_CQ_ENTRIES - cq_used - ctx->inflight : 0);
+  cnt = to_submit < sq_avail ? to_submit : sq_avail;
+  if (cnt > cq_room)
+    cnt = cq_room;
+  ctx->inflight += cnt;
+  lock_release (&ctx->lock);
+  enter_cnt++;
+  submit_cnt += cnt;
+
+  /* Consume the submissions.  Those that fail or need no work
+     complete at once. */
+  list_init (&batch);
+  for (i = 0; i < cnt; i++)
+    {
+      struct ioring_sqe *sqe = &ring->sqes[ctx->sq_head++ % IORING_SQ_ENTRIES];
+      struct ioring_req *r = malloc (sizeof *r);
+
+      if (r == NULL)
+        {
+          complete (ctx, NULL, sqe->user_data, -1);
+          continue;
+        }
+      r->ctx = ctx;
+      r->sqe = *sqe;
+      if (!prepare (r))
+        {
+          fail_cnt++;
+          complete (ctx, r, r->sqe.user_data, -1);
+        }
+      else if (r->sqe.op == IORING_OP_NOP)
+        complete (ctx, r, r->sqe.user_data, 0);
+      else
+        list_push_back (&batch, &r->elem);
+    }
+  barrier ();
+  ring->sq_head = ctx->sq_head;
+
+  /* Hand the rest to the pool threads. */
+  if (!list_empty (&batch))
+    {
+      lock_acquire (&queue_lock);
+      list_splice (list_end (&queue), list_begin (&batch), list_end (&batch));
+      cond_broadcast (&queue_nonempty, &queue_lock);
+      lock_release (&queue_lock);
+    }
+
+  if (min_complete > 0)
+    {
+      lock_acquire (&ctx->lock);
+      if (ctx->cq_tail - ring->cq_head < min_complete && ctx->inflight > 0)
+        wait_cnt++;
+      while (ctx->cq_tail - ring->cq_head < min_complete && ctx->inflight > 0)
+        cond_wait (&ctx->done, &ctx->lock);
+      lock_release (&ctx->lock);
+    }
+  return cnt;
+}
+
+/* Waits for the current process's requests to finish.  fork()
+   calls this first: a read still in flight writes into a pinned
+   frame by its kernel address, so if that frame were shared
+   copy-on-write with the child, the child would see data it
+   never asked for, and the parent would lose whatever arrived
+   after its first write to the page. */
+void
+ioring_quiesce (void)
+{
+  struct ioring_ctx *ctx = thread_current ()->ioring;
+
+  if (ctx == NULL)
+    return;
+
+  lock_acquire (&ctx->lock);
+  while (ctx->inflight > 0)
+    cond_wait (&ctx->done, &ctx->lock);
+  lock_release (&ctx->lock);
+}
+
+/* Waits for the current process's requests to finish, then
+   unmaps and frees its rings.  Must be called before the process
+   closes its files and frees its memory. */
+void
+ioring_destroy (void)
+{
+  struct thread *t = thread_current ();
+  struct ioring_ctx *ctx = t->ioring;
+
+  if (ctx == NULL)
+    return;
+
+  ioring_quiesce ();
+  pagedir_clear_page (t->pagedir, ctx->upage);
+  palloc_free_page (ctx->ring);
+  free (ctx);
+  t->ioring = NULL;
+}
+
+/* Prints ring statistics. */
+void
+ioring_print_stats (void)
+{
+  printf ("Ioring: %lld operations submitted in %lld calls, "
+          "%lld rejected, %lld waits\n",
+          submit_cnt, enter_cnt, fail_cnt, wait_cnt);
+}
+
+/* Pool thread: carries out queued requests. */
+static void
+worker (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct ioring_req *r;
+
+      lock_acquire (&queue_lock);
+      while (list_empty (&queue))
+        cond_wait (&queue_nonempty, &queue_lock);
+      r = list_entry (list_pop_front (&queue), struct ioring_req, elem);
+      lock_release (&queue_lock);
+
+      complete (r->ctx, r, r->sqe.user_data, execute (r));
+    }
+}
+
+/* Makes request R, which holds a copy of its submission, ready
+   to be carried out by another thread: copies in its file name
+   or pins its buffer.  Must be called by the submitting process.
+   Returns true if successful, false if the submission is
+   invalid. */
+static bool
+prepare (struct ioring_req *r)
+{
+  r->iov_cnt = 0;
+  switch (r->sqe.op)
+    {
+    case IORING_OP_NOP:
+    case IORING_OP_CLOSE:
+    case IORING_OP_FSYNC:
+      return true;
+
+    case IORING_OP_READ:
+      return pin_buffer (r, true);
+
+    case IORING_OP_WRITE:
+      return pin_buffer (r, false);
+
+    case IORING_OP_OPEN:
+      return syscall_copy_string (r->name, r->sqe.addr, sizeof r->name);
+
+    default:
+      return false;
+    }
+}
+
+/* Carries out request R on behalf of the process that submitted
+   it and returns its result. */
+static int
+execute (struct ioring_req *r)
+{
+  struct thread *owner = r->ctx->owner;
+  const struct ioring_sqe *sqe = &r->sqe;
+  struct file *file;
+  int result = -1;
+
+  lock_acquire (&filesys_lock);
+  switch (sqe->op)
+    {
+    case IORING_OP_READ:
+      file = fd_table_get (&owner->fds, sqe->fd);
+      if (file != NULL)
+        result = (sqe->ofs < 0
+                  ? file_readv (file, r->iov, r->iov_cnt)
+                  : file_readv_at (file, r->iov, r->iov_cnt, sqe->ofs));
+      break;
+
+    case IORING_OP_WRITE:
+      file = fd_table_get (&owner->fds, sqe->fd);
+      if (file != NULL)
+        result = (sqe->ofs < 0
+                  ? file_writev (file, r->iov, r->iov_cnt)
+                  : file_writev_at (file, r->iov, r->iov_cnt, sqe->ofs));
+      break;
+
+    case IORING_OP_OPEN:
+      file = filesys_open (r->name);
+      if (file != NULL
+          && (result = fd_table_add (&owner->fds, file, true)) < 0)
+        file_close (file);
+      break;
+
+    case IORING_OP_CLOSE:
+      result = fd_table_close (&owner->fds, sqe->fd) ? 0 : -1;
+      break;
+
+    case IORING_OP_FSYNC:
+      result = fd_table_get (&owner->fds, sqe->fd) != NULL ? 0 : -1;
+      break;
+
+    default:
+      NOT_REACHED ();
+    }
+  lock_release (&filesys_lock);
+  return result;
+}
+
+/* Posts a completion with USER_DATA and RES to CTX's completion
+   ring, into a slot that was reserved when it was submitted, and
+   frees request R, if it is nonnull. */
+static void
+complete (struct ioring_ctx *ctx, struct ioring_req *r,
+          uint32_t user_data, int res)
+{
+  struct ioring_cqe *cqe;
+
+  if (r != NULL)
+    {
+      unpin_buffer (r);
+      free (r);
+    }
+
+  lock_acquire (&ctx->lock);
+  cqe = &ctx->ring->cqes[ctx->cq_tail++ % IORING_CQ_ENTRIES];
+  cqe->user_data = user_data;
+  cqe->res = res;
+  barrier ();
+  ctx->ring->cq_tail = ctx->cq_tail;
+  ctx->inflight--;
+  cond_broadcast (&ctx->done, &ctx->lock);
+  lock_release (&ctx->lock);
+}
+
+/* Pins the pages of request R's buffer in memory and describes
+   them by kernel address in R's I/O vector.  If WRITE is true,
+   the buffer must be writable.  Must be called by the submitting
+   process.  Returns true if successful, false if the buffer is
+   too big or not valid user memory. */
+static bool
+pin_buffer (struct ioring_req *r, bool write)
+{
+  uint8_t *p = r->sqe.addr;
+  size_t left = r->sqe.len;
+
+  if (left > IORING_MAX_LEN)
+    return false;
+  while (left > 0)
+    {
+      size_t ofs = pg_ofs (p);
+      size_t chunk = PGSIZE - ofs < left ? PGSIZE - ofs : left;
+      uint8_t *kpage = NULL;
+#ifdef VM
+      int try;
+
+      /* The page can be evicted again between touching and
+         pinning it, but that is unlikely to happen repeatedly. */
+      for (try = 0; try < 3 && kpage == NULL; try++)
+        if (syscall_probe_user (p, 1, write))
+          {
+            struct frame *f = page_pin (p, write);
+            if (f != NULL)
+              {
+                r->frames[r->iov_cnt] = f;
+                kpage = f->kpage;
+              }
+          }
+#else
+      /* Without virtual memory, user pages stay put. */
+      if (syscall_probe_user (p, 1, write))
+        kpage = pagedir_get_page (thread_current ()->pagedir, p - ofs);
+#endif
+      if (kpage == NULL)
+        {
+          unpin_buffer (r);
+          return false;
+        }
+
+      r->iov[r->iov_cnt].iov_base = kpage + ofs;
+      r->iov[r->iov_cnt].iov_len = chunk;
+      r->iov_cnt++;
+      p += chunk;
+      left -= chunk;
+    }
+  return true;
+}
+
+/* Undoes pin_buffer() for request R. */
+static void
+unpin_buffer (struct ioring_req *r)
+{
+#ifdef VM
+  int i;
+
+  for (i = 0; i < r->iov_cnt; i++)
+    page_unpin (r->frames[i]);
+#endif
+  r->iov_cnt = 0;
+}
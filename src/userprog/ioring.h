@@ -0,0 +1,15 @@
+#ifndef USERPROG_IORING_H
+#define USERPROG_IORING_H
+
+#include <stddef.h>
+
+extern size_t ioring_worker_cnt;
+
+void ioring_init (void);
+void *ioring_setup (void *upage);
+int ioring_enter (unsigned to_submit, unsigned min_complete);
+void ioring_quiesce (void);
+void ioring_destroy (void);
+void ioring_print_stats (void);
+
+#endif /* userprog/ioring.h */
@@ -2,12 +2,42 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 
+/* Maximum number of pages whose TLB entries a range operation
+   invalidates one at a time with invlpg.  For larger ranges it
+   is cheaper to flush the whole TLB by reloading CR3. */
+#define INVLPG_MAX 32
+
+/* TLB invalidation for a range operation. */
+struct tlb_flush
+  {
+    uint32_t *pd;               /* Page directory being changed. */
+    bool active;                /* Is PD the active page directory? */
+    bool each;                  /* Invalidate page by page? */
+    bool pending;               /* Full flush needed at the end? */
+  };
+
+/* A run of physically contiguous pages to be freed together. */
+struct free_run
+  {
+    uint8_t *start;             /* First page in run. */
+    size_t cnt;                 /* Number of pages in run. */
+  };
+
 static uint32_t *active_pd (void);
 static void invalidate_pagedir (uint32_t *);
+static void invalidate_page (uint32_t *, const void *);
+static void flush_init (struct tlb_flush *, uint32_t *pd, size_t page_cnt);
+static void flush_page (struct tlb_flush *, const void *);
+static void flush_finish (struct tlb_flush *);
+static void free_run_add (struct free_run *, void *page);
+static void free_run_finish (struct free_run *);
+static uint8_t *pt_span_end (const uint8_t *vaddr, const uint8_t *end);
+static bool pt_is_empty (const uint32_t *pt);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -27,23 +57,11 @@ pagedir_create (void)
 void
 pagedir_destroy (uint32_t *pd) 
 {
-  uint32_t *pde;
-
   if (pd == NULL)
     return;
 
   ASSERT (pd != init_page_dir);
-  for (pde = pd; pde < pd + pd_no (PHYS_BASE); pde++)
-    if (*pde & PTE_P) 
-      {
-        uint32_t *pt = pde_get_pt (*pde);
-        uint32_t *pte;
-        
-        for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
-          if (*pte & PTE_P) 
-            palloc_free_page (pte_get_page (*pte));
-        palloc_free_page (pt);
-      }
+  pagedir_unmap_range (pd, NULL, pd_no (PHYS_BASE) * (PTSPAN / PGSIZE), true);
   palloc_free_page (pd);
 }
 
@@ -52,7 +70,10 @@ pagedir_destroy (uint32_t *pd)
    If PD does not have a page table for VADDR, behavior depends
    on CREATE.  If CREATE is true, then a new page table is
    created and a pointer into it is returned.  Otherwise, a null
-   pointer is returned. */
+   pointer is returned.
+   If VADDR lies within a large page, returns the PDE that maps
+   the large page, whose accessed and dirty bits are in the same
+   places as a PTE's.  CREATE must be false in this case. */
 static uint32_t *
 lookup_page (uint32_t *pd, const void *vaddr, bool create)
 {
@@ -66,6 +87,11 @@ lookup_page (uint32_t *pd, const void *vaddr, bool create)
   /* Check for a page table for VADDR.
      If one is missing, create one if requested. */
   pde = pd + pd_no (vaddr);
+  if (pde_is_large (*pde))
+    {
+      ASSERT (!create);
+      return pde;
+    }
   if (*pde == 0) 
     {
       if (create)
@@ -118,6 +144,48 @@ pagedir_set_page (uint32_t *pd, void *upage, void *kpage, bool writable)
     return false;
 }
 
+/* Adds a mapping in page directory PD from the 4 MB user
+   virtual region starting at UPAGE to the 4 MB large page at
+   kernel virtual address KPAGE.
+   UPAGE and KPAGE must both be 4 MB aligned, and no page in the
+   region may already be mapped.
+   KPAGE should probably be obtained from the user pool with
+   palloc_get_multiple_aligned().
+   If WRITABLE is true, the new page is read/write;
+   otherwise it is read-only.
+   Returns true if successful, false if the CPU does not support
+   large pages. */
+bool
+pagedir_set_large_page (uint32_t *pd, void *upage, void *kpage,
+                        bool writable)
+{
+  uint32_t *pde;
+
+  ASSERT (((uintptr_t) upage & LGPGMASK) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (pd != init_page_dir);
+
+  if (!init_large_pages)
+    return false;
+
+  pde = pd + pd_no (upage);
+  if (*pde & PTE_P)
+    {
+      /* Drop an empty page table left behind by earlier
+         mappings. */
+      uint32_t *pt = pde_get_pt (*pde);
+      size_t i;
+
+      for (i = 0; i < PGSIZE / sizeof *pt; i++)
+        ASSERT ((pt[i] & PTE_P) == 0);
+      palloc_free_page (pt);
+      *pde = 0;
+      invalidate_page (pd, upage);
+    }
+  *pde = pde_create_large_user (kpage, writable);
+  return true;
+}
+
 /* Looks up the physical address that corresponds to user virtual
    address UADDR in PD.  Returns the kernel virtual address
    corresponding to that physical address, or a null pointer if
@@ -130,7 +198,9 @@ pagedir_get_page (uint32_t *pd, const void *uaddr)
   ASSERT (is_user_vaddr (uaddr));
   
   pte = lookup_page (pd, uaddr, false);
-  if (pte != NULL && (*pte & PTE_P) != 0)
+  if (pte != NULL && pde_is_large (*pte))
+    return pde_get_large_page (*pte) + ((uintptr_t) uaddr & LGPGMASK);
+  else if (pte != NULL && (*pte & PTE_P) != 0)
     return pte_get_page (*pte) + pg_ofs (uaddr);
   else
     return NULL;
@@ -139,7 +209,9 @@ pagedir_get_page (uint32_t *pd, const void *uaddr)
 /* Marks user virtual page UPAGE "not present" in page
    directory PD.  Later accesses to the page will fault.  Other
    bits in the page table entry are preserved.
-   UPAGE need not be mapped. */
+   UPAGE need not be mapped.
+   If UPAGE lies within a large page, the whole large page is
+   unmapped; the caller is responsible for freeing it. */
 void
 pagedir_clear_page (uint32_t *pd, void *upage) 
 {
@@ -149,10 +221,15 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   ASSERT (is_user_vaddr (upage));
 
   pte = lookup_page (pd, upage, false);
-  if (pte != NULL && (*pte & PTE_P) != 0)
+  if (pte != NULL && pde_is_large (*pte))
+    {
+      *pte = 0;
+      invalidate_page (pd, upage);
+    }
+  else if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
     }
 }
 
@@ -180,7 +257,7 @@ pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
       else 
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -209,9 +286,253 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
       else 
         {
           *pte &= ~(uint32_t) PTE_A; 
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
+        }
+    }
+}
+
+/* Adds mappings in page directory PD for the PAGE_CNT user
+   virtual pages starting at UPAGE, mapping the Nth of them to
+   the physical frame identified by kernel virtual address
+   KPAGES[N].
+   None of the pages may already be mapped.
+   If WRITABLE is true, the new pages are read/write;
+   otherwise they are read-only.
+   Looks up each page table only once, so this is cheaper than
+   calling pagedir_set_page() for each page.
+   Returns true if successful.  Returns false if memory
+   allocation failed or if some page in the range was already
+   mapped, in which case no new mappings are left behind. */
+bool
+pagedir_map_range (uint32_t *pd, void *upage, void *const kpages[],
+                   size_t page_cnt, bool writable)
+{
+  uint8_t *vaddr = upage;
+  uint8_t *end = vaddr + page_cnt * PGSIZE;
+  size_t i = 0;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (page_cnt <= (size_t) ((uint8_t *) PHYS_BASE - vaddr) / PGSIZE);
+  ASSERT (pd != init_page_dir);
+
+  while (vaddr < end)
+    {
+      uint8_t *span_end = pt_span_end (vaddr, end);
+      uint32_t *pte;
+
+      if (pde_is_large (pd[pd_no (vaddr)]))
+        goto fail;
+      pte = lookup_page (pd, vaddr, true);
+      if (pte == NULL)
+        goto fail;
+
+      for (; vaddr < span_end; vaddr += PGSIZE, pte++, i++)
+        {
+          ASSERT (pg_ofs (kpages[i]) == 0);
+          ASSERT (vtop (kpages[i]) >> PTSHIFT < init_ram_pages);
+          if (*pte & PTE_P)
+            goto fail;
+          *pte = pte_create_user (kpages[i], writable);
         }
     }
+  return true;
+
+ fail:
+  pagedir_unmap_range (pd, upage, i, false);
+  return false;
+}
+
+/* Removes the mappings in page directory PD for the PAGE_CNT
+   user virtual pages starting at UPAGE.  Unlike
+   pagedir_clear_page(), the page table entries are zeroed, and
+   page tables left with no entries are freed.  The range need
+   not be mapped, but it must cover any large page within it
+   entirely.
+   If FREE_PAGES is true, the frames that were mapped are freed
+   with palloc_free_multiple(), combining frames that are
+   contiguous in physical memory; otherwise they are left to the
+   caller. */
+void
+pagedir_unmap_range (uint32_t *pd, void *upage, size_t page_cnt,
+                     bool free_pages)
+{
+  uint8_t *vaddr = upage;
+  uint8_t *end = vaddr + page_cnt * PGSIZE;
+  struct tlb_flush flush;
+  struct free_run run;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (page_cnt <= (size_t) ((uint8_t *) PHYS_BASE - vaddr) / PGSIZE);
+  ASSERT (pd != init_page_dir);
+
+  flush_init (&flush, pd, page_cnt);
+  run.cnt = 0;
+  for (; vaddr < end; vaddr = pt_span_end (vaddr, end))
+    {
+      uint32_t *pde = pd + pd_no (vaddr);
+      uint8_t *span_end = pt_span_end (vaddr, end);
+
+      if (pde_is_large (*pde))
+        {
+          ASSERT (span_end == vaddr + PTSPAN);
+          if (free_pages)
+            palloc_free_multiple (pde_get_large_page (*pde), PTSPAN / PGSIZE);
+          *pde = 0;
+          flush_page (&flush, vaddr);
+        }
+      else if (*pde & PTE_P)
+        {
+          uint32_t *pt = pde_get_pt (*pde);
+          uint32_t *pte = pt + pt_no (vaddr);
+          uint8_t *p;
+
+          for (p = vaddr; p < span_end; p += PGSIZE, pte++)
+            if (*pte != 0)
+              {
+                if (*pte & PTE_P)
+                  {
+                    if (free_pages)
+                      free_run_add (&run, pte_get_page (*pte));
+                    flush_page (&flush, p);
+                  }
+                *pte = 0;
+              }
+
+          if (span_end == vaddr + PTSPAN || pt_is_empty (pt))
+            {
+              *pde = 0;
+              palloc_free_page (pt);
+              flush_page (&flush, vaddr);
+            }
+        }
+    }
+  flush_finish (&flush);
+  free_run_finish (&run);
+}
+
+/* Makes the mapped pages among the PAGE_CNT user virtual pages
+   starting at UPAGE in PD read/write if WRITABLE is true,
+   read-only otherwise.  Unmapped pages in the range are
+   skipped.  The range must cover any large page within it
+   entirely. */
+void
+pagedir_protect_range (uint32_t *pd, void *upage, size_t page_cnt,
+                       bool writable)
+{
+  uint8_t *vaddr = upage;
+  uint8_t *end = vaddr + page_cnt * PGSIZE;
+  struct tlb_flush flush;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (page_cnt <= (size_t) ((uint8_t *) PHYS_BASE - vaddr) / PGSIZE);
+
+  flush_init (&flush, pd, page_cnt);
+  for (; vaddr < end; vaddr = pt_span_end (vaddr, end))
+    {
+      uint32_t *pde = pd + pd_no (vaddr);
+      uint8_t *span_end = pt_span_end (vaddr, end);
+      uint32_t *pte, *pte_end;
+      uint8_t *p = vaddr;
+
+      if (pde_is_large (*pde))
+        {
+          ASSERT (span_end == vaddr + PTSPAN);
+          pte = pde;
+          pte_end = pde + 1;
+        }
+      else if (*pde & PTE_P)
+        {
+          pte = pde_get_pt (*pde) + pt_no (vaddr);
+          pte_end = pte + (span_end - vaddr) / PGSIZE;
+        }
+      else
+        continue;
+
+      for (; pte < pte_end; pte++, p += PGSIZE)
+        if ((*pte & PTE_P) && !(*pte & PTE_W) != !writable)
+          {
+            *pte ^= PTE_W;
+            flush_page (&flush, p);
+          }
+    }
+  flush_finish (&flush);
+}
+
+/* Reports the accessed and dirty bits for the PAGE_CNT user
+   virtual pages starting at UPAGE in PD.  If BITS is nonnull,
+   stores a combination of PD_ACCESSED and PD_DIRTY for the Nth
+   page into BITS[N]; unmapped pages get 0, and each page within
+   a large page gets the large page's bits.  Clears the bits in
+   CLEAR from every page in the range, so that passing
+   PD_ACCESSED implements one sweep of a clock algorithm.
+   Returns the number of pages that had any bit set. */
+size_t
+pagedir_query_range (uint32_t *pd, const void *upage, size_t page_cnt,
+                     uint8_t bits[], enum pagedir_bits clear)
+{
+  const uint8_t *vaddr = upage;
+  const uint8_t *end = vaddr + page_cnt * PGSIZE;
+  uint32_t clear_mask = ((clear & PD_ACCESSED ? PTE_A : 0)
+                         | (clear & PD_DIRTY ? PTE_D : 0));
+  struct tlb_flush flush;
+  size_t set_cnt = 0;
+  size_t i = 0;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (page_cnt <= (size_t) ((uint8_t *) PHYS_BASE - vaddr) / PGSIZE);
+
+  flush_init (&flush, pd, page_cnt);
+  for (; vaddr < end; vaddr = pt_span_end (vaddr, end))
+    {
+      uint32_t *pde = pd + pd_no (vaddr);
+      const uint8_t *span_end = pt_span_end (vaddr, end);
+      bool large = pde_is_large (*pde);
+      uint32_t *pte = NULL;
+      const uint8_t *p;
+
+      if (large)
+        pte = pde;
+      else if (*pde & PTE_P)
+        pte = pde_get_pt (*pde) + pt_no (vaddr);
+
+      for (p = vaddr; p < span_end; p += PGSIZE, i++)
+        {
+          uint8_t page_bits = 0;
+
+          if (pte != NULL && (*pte & PTE_P))
+            {
+              if (*pte & PTE_A)
+                page_bits |= PD_ACCESSED;
+              if (*pte & PTE_D)
+                page_bits |= PD_DIRTY;
+              if (!large && (*pte & clear_mask))
+                {
+                  *pte &= ~clear_mask;
+                  flush_page (&flush, p);
+                }
+            }
+          if (bits != NULL)
+            bits[i] = page_bits;
+          if (page_bits != 0)
+            set_cnt++;
+
+          if (pte != NULL && !large)
+            pte++;
+        }
+
+      if (large && (*pde & clear_mask))
+        {
+          *pde &= ~clear_mask;
+          flush_page (&flush, vaddr);
+        }
+    }
+  flush_finish (&flush);
+
+  return set_cnt;
 }
 
 /* Loads page directory PD into the CPU's page directory base
@@ -256,8 +577,97 @@ invalidate_pagedir (uint32_t *pd)
 {
   if (active_pd () == pd) 
     {
-      /* Re-activating PD clears the TLB.  See [IA32-v3a] 3.12
-         "Translation Lookaside Buffers (TLBs)". */
+      /* Re-activating PD clears the TLB, except for the kernel's
+         global mappings, which never change.  See [IA32-v3a]
+         3.12 "Translation Lookaside Buffers (TLBs)". */
       pagedir_activate (pd);
     } 
 }
+
+/* Invalidates the TLB entry for user virtual address VADDR if PD
+   is the active page directory.  This is much cheaper than
+   invalidate_pagedir() when only one page has changed. */
+static void
+invalidate_page (uint32_t *pd, const void *vaddr)
+{
+  if (active_pd () == pd)
+    cpu_invlpg (vaddr);
+}
+
+/* Prepares F to invalidate the TLB for a range operation on
+   PAGE_CNT pages in PD. */
+static void
+flush_init (struct tlb_flush *f, uint32_t *pd, size_t page_cnt)
+{
+  f->pd = pd;
+  f->active = active_pd () == pd;
+  f->each = page_cnt <= INVLPG_MAX;
+  f->pending = false;
+}
+
+/* Records that the mapping for VADDR changed as part of the
+   range operation tracked by F. */
+static void
+flush_page (struct tlb_flush *f, const void *vaddr)
+{
+  if (!f->active)
+    return;
+  if (f->each)
+    cpu_invlpg (vaddr);
+  else
+    f->pending = true;
+}
+
+/* Completes the range operation tracked by F, flushing the
+   whole TLB if necessary. */
+static void
+flush_finish (struct tlb_flush *f)
+{
+  if (f->pending)
+    invalidate_pagedir (f->pd);
+}
+
+/* Adds PAGE to RUN, first freeing the pages already in RUN if
+   PAGE does not immediately follow them. */
+static void
+free_run_add (struct free_run *run, void *page)
+{
+  if (run->cnt > 0 && run->start + run->cnt * PGSIZE == page)
+    run->cnt++;
+  else
+    {
+      free_run_finish (run);
+      run->start = page;
+      run->cnt = 1;
+    }
+}
+
+/* Frees the pages in RUN and empties it. */
+static void
+free_run_finish (struct free_run *run)
+{
+  if (run->cnt > 0)
+    palloc_free_multiple (run->start, run->cnt);
+  run->cnt = 0;
+}
+
+/* Returns the end of the part of [VADDR, END) that is mapped by
+   the same page directory entry as VADDR. */
+static uint8_t *
+pt_span_end (const uint8_t *vaddr, const uint8_t *end)
+{
+  uint8_t *next = (uint8_t *) (((uintptr_t) vaddr | LGPGMASK) + 1);
+  return next < end ? next : (uint8_t *) end;
+}
+
+/* Returns true if page table PT has no nonzero entries. */
+static bool
+pt_is_empty (const uint32_t *pt)
+{
+  size_t i;
+
+  for (i = 0; i < PGSIZE / sizeof *pt; i++)
+    if (pt[i] != 0)
+      return false;
+  return true;
+}
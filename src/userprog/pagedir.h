@@ -2,17 +2,35 @@
 #define USERPROG_PAGEDIR_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+/* Page table bits reported and cleared by pagedir_query_range(). */
+enum pagedir_bits
+  {
+    PD_ACCESSED = 001,          /* Page has been accessed. */
+    PD_DIRTY = 002              /* Page has been written. */
+  };
+
 uint32_t *pagedir_create (void);
 void pagedir_destroy (uint32_t *pd);
 bool pagedir_set_page (uint32_t *pd, void *upage, void *kpage, bool rw);
+bool pagedir_set_large_page (uint32_t *pd, void *upage, void *kpage,
+                             bool rw);
 void *pagedir_get_page (uint32_t *pd, const void *upage);
 void pagedir_clear_page (uint32_t *pd, void *upage);
 bool pagedir_is_dirty (uint32_t *pd, const void *upage);
 void pagedir_set_dirty (uint32_t *pd, const void *upage, bool dirty);
 bool pagedir_is_accessed (uint32_t *pd, const void *upage);
 void pagedir_set_accessed (uint32_t *pd, const void *upage, bool accessed);
+bool pagedir_map_range (uint32_t *pd, void *upage, void *const kpages[],
+                        size_t page_cnt, bool rw);
+void pagedir_unmap_range (uint32_t *pd, void *upage, size_t page_cnt,
+                          bool free_pages);
+void pagedir_protect_range (uint32_t *pd, void *upage, size_t page_cnt,
+                            bool rw);
+size_t pagedir_query_range (uint32_t *pd, const void *upage, size_t page_cnt,
+                            uint8_t bits[], enum pagedir_bits clear);
 void pagedir_activate (uint32_t *pd);
 
 #endif /* userprog/pagedir.h */
@@ -5,8 +5,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <timepage.h>
+#include "devices/timer.h"
+#include "userprog/elfcache.h"
 #include "userprog/gdt.h"
+#include "userprog/ioring.h"
 #include "userprog/pagedir.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
@@ -14,55 +19,178 @@
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
+
+/* If true, map 4 MB-aligned runs of program segments with 4 MB
+   pages where the hardware and the user pool allow it.  If
+   false (default), use 4 kB pages only.
+   Controlled by kernel command-line option "-lp". */
+bool process_large_pages;
+
+/* Maximum number of pages that load_segment() maps at once. */
+#define LOAD_BATCH 64
 
 static thread_func start_process NO_RETURN;
+#ifdef VM
+static thread_func start_fork NO_RETURN;
+#endif
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
+static bool map_time_page (void);
+
+/* A child process's exit status, shared between the child and
+   its parent, so that the parent can wait for the child even
+   after it has exited, and the child can exit even after the
+   parent has. */
+struct wait_status
+  {
+    struct list_elem elem;              /* Element in parent's children. */
+    tid_t tid;                          /* Child's thread id. */
+    int exit_status;                    /* Child's exit status. */
+    struct semaphore dead;              /* Upped when the child exits. */
+    int ref_cnt;                        /* 2 = both alive, 1 = one, 0 = none. */
+  };
+
+/* Protects the ref_cnt members of all wait_status structures. */
+static struct lock wait_lock;
+
+/* Information passed from process_execute() to the child. */
+struct exec_info
+  {
+    const char *cmdline;                /* Program name and arguments. */
+    struct thread *parent;              /* Process calling exec(). */
+    struct wait_status *wait_status;    /* Child's exit status. */
+    struct semaphore loaded;            /* Upped when load is done. */
+    bool success;                       /* Did load succeed? */
+  };
+
+/* Initializes process management. */
+void
+process_init (void)
+{
+  lock_init (&wait_lock);
+}
+
+/* Creates a wait_status for a new child of the current process
+   and adds it to the current process's list of children.
+   Returns the new wait_status, or a null pointer if memory
+   allocation fails. */
+static struct wait_status *
+add_child (void)
+{
+  struct wait_status *ws = malloc (sizeof *ws);
+
+  if (ws != NULL)
+    {
+      ws->tid = TID_ERROR;
+      ws->exit_status = -1;
+      sema_init (&ws->dead, 0);
+      ws->ref_cnt = 2;
+      list_push_back (&thread_current ()->children, &ws->elem);
+    }
+  return ws;
+}
+
+/* Drops a reference to WS, freeing it if it was the last. */
+static void
+release_child (struct wait_status *ws)
+{
+  int ref_cnt;
+
+  lock_acquire (&wait_lock);
+  ref_cnt = --ws->ref_cnt;
+  lock_release (&wait_lock);
+  if (ref_cnt == 0)
+    free (ws);
+}
+
+/* Removes WS, a child of the current process whose thread could
+   not be created, and frees it. */
+static void
+remove_child (struct wait_status *ws)
+{
+  list_remove (&ws->elem);
+  free (ws);
+}
 
 /* Starts a new thread running a user program loaded from
-   FILENAME.  The new thread may be scheduled (and may even exit)
-   before process_execute() returns.  Returns the new process's
-   thread id, or TID_ERROR if the thread cannot be created. */
+   CMDLINE, which consists of the program's name followed by its
+   arguments, separated by spaces.  Returns the new process's
+   thread id, or TID_ERROR if the thread cannot be created or the
+   program cannot be loaded. */
 tid_t
-process_execute (const char *file_name) 
+process_execute (const char *cmdline)
 {
-  char *fn_copy;
+  char name[16];
+  struct exec_info info;
   tid_t tid;
 
-  /* Make a copy of FILE_NAME.
-     Otherwise there's a race between the caller and load(). */
-  fn_copy = palloc_get_page (0);
-  if (fn_copy == NULL)
+  /* Name the thread after the program. */
+  strlcpy (name, cmdline + strspn (cmdline, " "), sizeof name);
+  name[strcspn (name, " ")] = '\0';
+
+  info.cmdline = cmdline;
+  info.parent = thread_current ();
+  info.wait_status = add_child ();
+  if (info.wait_status == NULL)
     return TID_ERROR;
-  strlcpy (fn_copy, file_name, PGSIZE);
+  sema_init (&info.loaded, 0);
+  info.success = false;
 
-  /* Create a new thread to execute FILE_NAME. */
-  tid = thread_create (file_name, PRI_DEFAULT, start_process, fn_copy);
+  /* Create a new thread to execute CMDLINE, and wait for it to
+     load the program: INFO, and CMDLINE, belong to us. */
+  tid = thread_create (name, PRI_DEFAULT, start_process, &info);
   if (tid == TID_ERROR)
-    palloc_free_page (fn_copy); 
+    {
+      remove_child (info.wait_status);
+      return TID_ERROR;
+    }
+  info.wait_status->tid = tid;
+  sema_down (&info.loaded);
+  if (!info.success)
+    {
+      /* Reap the child, which is exiting. */
+      process_wait (tid);
+      return TID_ERROR;
+    }
   return tid;
 }
 
 /* A thread function that loads a user process and starts it
    running. */
 static void
-start_process (void *file_name_)
+start_process (void *info_)
 {
-  char *file_name = file_name_;
+  struct exec_info *info = info_;
+  struct thread *t = thread_current ();
   struct intr_frame if_;
   bool success;
 
+  t->wait_status = info->wait_status;
+
   /* Initialize interrupt frame and load executable. */
   memset (&if_, 0, sizeof if_);
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
-  success = load (file_name, &if_.eip, &if_.esp);
+  lock_acquire (&filesys_lock);
+  success = (fd_table_copy (&t->fds, &info->parent->fds, true)
+             && load (info->cmdline, &if_.eip, &if_.esp));
+  lock_release (&filesys_lock);
+
+  /* Let the parent go.  INFO lives on its stack. */
+  info->success = success;
+  sema_up (&info->loaded);
 
   /* If load failed, quit. */
-  palloc_free_page (file_name);
   if (!success) 
     thread_exit ();
 
@@ -76,18 +204,140 @@ start_process (void *file_name_)
   NOT_REACHED ();
 }
 
+#ifdef VM
+/* Information passed from process_fork() to the child. */
+struct fork_info
+  {
+    struct thread *parent;              /* Process being forked. */
+    struct wait_status *wait_status;    /* Child's exit status. */
+    struct intr_frame if_;              /* Parent's user registers. */
+    struct semaphore done;              /* Upped when child is set up. */
+    bool success;                       /* Did the copy succeed? */
+  };
+#endif
+
+/* Starts a new process that is a copy of the current one, which
+   entered the kernel with user registers IF_.  The child's
+   memory is shared with the parent copy-on-write, and it returns
+   to user mode where the parent did, but with 0 in EAX.  Returns
+   the child's thread id, or TID_ERROR if the process cannot be
+   copied.
+
+   Without VM there is no supplemental page table to share
+   pages through, so this always fails. */
+tid_t
+process_fork (const struct intr_frame *if_ UNUSED)
+{
+#ifdef VM
+  struct fork_info info;
+  tid_t tid;
+
+  /* Pinned buffers must not be shared copy-on-write. */
+  ioring_quiesce ();
+
+  info.parent = thread_current ();
+  info.wait_status = add_child ();
+  if (info.wait_status == NULL)
+    return TID_ERROR;
+  info.if_ = *if_;
+  sema_init (&info.done, 0);
+  info.success = false;
+
+  tid = thread_create (thread_name (), PRI_DEFAULT, start_fork, &info);
+  if (tid == TID_ERROR)
+    {
+      remove_child (info.wait_status);
+      return TID_ERROR;
+    }
+  info.wait_status->tid = tid;
+  sema_down (&info.done);
+  if (!info.success)
+    {
+      process_wait (tid);
+      return TID_ERROR;
+    }
+  return tid;
+#else
+  return TID_ERROR;
+#endif
+}
+
+#ifdef VM
+/* A thread function that copies the address space of the
+   process described by INFO_ (a struct fork_info) and starts it
+   running.  The parent waits until the copy is done. */
+static void
+start_fork (void *info_)
+{
+  struct fork_info *info = info_;
+  struct thread *t = thread_current ();
+  struct intr_frame if_ = info->if_;
+  bool success = false;
+
+  t->wait_status = info->wait_status;
+  t->pagedir = pagedir_create ();
+  if (t->pagedir != NULL)
+    {
+      process_activate ();
+      lock_acquire (&filesys_lock);
+      t->exec_file = file_reopen (info->parent->exec_file);
+      if (!fd_table_copy (&t->fds, &info->parent->fds, false))
+        {
+          file_close (t->exec_file);
+          t->exec_file = NULL;
+        }
+      lock_release (&filesys_lock);
+      if (t->exec_file != NULL)
+        {
+          file_deny_write (t->exec_file);
+          t->pages = page_table_copy (info->parent->pages,
+                                      info->parent->exec_file, t->exec_file);
+          success = t->pages != NULL && map_time_page ();
+        }
+    }
+
+  /* INFO lives on the parent's stack, which may be gone as soon
+     as the parent wakes up. */
+  info->success = success;
+  sema_up (&info->done);
+  if (!success)
+    thread_exit ();
+
+  /* Return to user mode as in start_process(), with fork()'s
+     return value for the child. */
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+#endif /* VM */
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
    child of the calling process, or if process_wait() has already
    been successfully called for the given TID, returns -1
-   immediately, without waiting.
-
-   This function will be implemented in problem 2-2.  For now, it
-   does nothing. */
+   immediately, without waiting. */
 int
-process_wait (tid_t child_tid UNUSED) 
+process_wait (tid_t child_tid) 
 {
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&cur->children); e != list_end (&cur->children);
+       e = list_next (e))
+    {
+      struct wait_status *ws = list_entry (e, struct wait_status, elem);
+      if (ws->tid == child_tid)
+        {
+          int status;
+
+          sema_down (&ws->dead);
+          status = ws->exit_status;
+          list_remove (&ws->elem);
+          release_child (ws);
+          return status;
+        }
+    }
   return -1;
 }
 
@@ -98,6 +348,42 @@ process_exit (void)
   struct thread *cur = thread_current ();
   uint32_t *pd;
 
+  if (cur->pagedir != NULL)
+    printf ("%s: exit(%d)\n", cur->name, cur->exit_status);
+
+  /* Tell our parent how we exited, and let go of our children. */
+  if (cur->wait_status != NULL)
+    {
+      cur->wait_status->exit_status = cur->exit_status;
+      sema_up (&cur->wait_status->dead);
+      release_child (cur->wait_status);
+      cur->wait_status = NULL;
+    }
+  while (!list_empty (&cur->children))
+    release_child (list_entry (list_pop_front (&cur->children),
+                               struct wait_status, elem));
+
+  /* Let requests in flight finish before their files and buffers
+     go away. */
+  ioring_destroy ();
+
+  lock_acquire (&filesys_lock);
+  fd_table_destroy (&cur->fds);
+  lock_release (&filesys_lock);
+
+#ifdef VM
+  /* Write back memory-mapped files, then free the process's
+     pages, frames, and swap slots, while its page directory is
+     still in place. */
+  mmap_unmap_all ();
+  page_table_destroy (cur->pages);
+  cur->pages = NULL;
+  lock_acquire (&filesys_lock);
+  file_close (cur->exec_file);
+  lock_release (&filesys_lock);
+  cur->exec_file = NULL;
+#endif
+
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -112,6 +398,8 @@ process_exit (void)
          that's been freed (and cleared). */
       cur->pagedir = NULL;
       pagedir_activate (NULL);
+      if (pagedir_get_page (pd, TIMEPAGE_ADDR) == timer_time_page ())
+        pagedir_clear_page (pd, TIMEPAGE_ADDR);
       pagedir_destroy (pd);
     }
 }
@@ -196,24 +484,32 @@ struct Elf32_Phdr
 #define PF_R 4          /* Readable. */
 
 static bool setup_stack (void **esp);
+static bool push_args (const char *cmdline, void **esp);
+static struct elf_image *read_image (struct file *, const char *file_name);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
                           bool writable);
 
-/* Loads an ELF executable from FILE_NAME into the current thread.
-   Stores the executable's entry point into *EIP
-   and its initial stack pointer into *ESP.
-   Returns true if successful, false otherwise. */
+/* Loads an ELF executable into the current thread from the file
+   named by the first word of CMDLINE, and passes it the words of
+   CMDLINE as arguments.  Stores the executable's entry point
+   into *EIP and its initial stack pointer into *ESP.  Returns
+   true if successful, false otherwise. */
 bool
-load (const char *file_name, void (**eip) (void), void **esp) 
+load (const char *cmdline, void (**eip) (void), void **esp) 
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
+  char file_name[NAME_MAX + 2];
+  struct elf_image *image;
   struct file *file = NULL;
-  off_t file_ofs;
   bool success = false;
-  int i;
+  size_t i;
+
+  /* Extract the program name.  One that is too long to fit in
+     FILE_NAME is too long to be a file name. */
+  strlcpy (file_name, cmdline + strspn (cmdline, " "), sizeof file_name);
+  file_name[strcspn (file_name, " ")] = '\0';
 
   /* Allocate and activate page directory. */
   t->pagedir = pagedir_create ();
@@ -221,6 +517,13 @@ load (const char *file_name, void (**eip) (void), void **esp)
     goto done;
   process_activate ();
 
+#ifdef VM
+  /* Allocate supplemental page table. */
+  t->pages = page_table_create ();
+  if (t->pages == NULL)
+    goto done;
+#endif
+
   /* Open executable file. */
   file = filesys_open (file_name);
   if (file == NULL) 
@@ -229,6 +532,70 @@ load (const char *file_name, void (**eip) (void), void **esp)
       goto done; 
     }
 
+  /* Parse the executable's headers, unless they are cached. */
+  image = elf_cache_lookup (file);
+  if (image == NULL)
+    {
+      image = read_image (file, file_name);
+      if (image == NULL)
+        goto done;
+      elf_cache_insert (file, image);
+    }
+
+  /* Map its segments. */
+  for (i = 0; i < image->seg_cnt; i++)
+    {
+      const struct elf_segment *seg = &image->segs[i];
+      if (!load_segment (file, seg->file_page, (void *) seg->mem_page,
+                         seg->read_bytes, seg->zero_bytes, seg->writable))
+        goto done;
+    }
+
+  /* Set up stack. */
+  if (!setup_stack (esp) || !push_args (cmdline, esp))
+    goto done;
+
+  if (!map_time_page ())
+    goto done;
+
+  /* Start address. */
+  *eip = (void (*) (void)) image->entry;
+
+  success = true;
+
+ done:
+  /* We arrive here whether the load is successful or not. */
+#ifdef VM
+  /* Pages are read from the executable as they are touched, so
+     it stays open, and unmodified, until the process exits. */
+  if (success)
+    {
+      file_deny_write (file);
+      t->exec_file = file;
+    }
+  else
+    file_close (file);
+#else
+  file_close (file);
+#endif
+  return success;
+}
+
+/* load() helpers. */
+
+/* Reads and checks the ELF header and program headers of FILE,
+   an executable named FILE_NAME, and returns what load() needs
+   to map it, in a block allocated with malloc().  Returns a null
+   pointer if FILE is not a valid executable or if memory
+   allocation fails. */
+static struct elf_image *
+read_image (struct file *file, const char *file_name)
+{
+  struct Elf32_Ehdr ehdr;
+  struct elf_image *image;
+  off_t file_ofs;
+  int i;
+
   /* Read and verify executable header. */
   if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
@@ -239,9 +606,15 @@ load (const char *file_name, void (**eip) (void), void **esp)
       || ehdr.e_phnum > 1024) 
     {
       printf ("load: %s: error loading executable\n", file_name);
-      goto done; 
+      return NULL;
     }
 
+  image = malloc (sizeof *image + ehdr.e_phnum * sizeof *image->segs);
+  if (image == NULL)
+    return NULL;
+  image->entry = ehdr.e_entry;
+  image->seg_cnt = 0;
+
   /* Read program headers. */
   file_ofs = ehdr.e_phoff;
   for (i = 0; i < ehdr.e_phnum; i++) 
@@ -249,11 +622,11 @@ load (const char *file_name, void (**eip) (void), void **esp)
       struct Elf32_Phdr phdr;
 
       if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
+        goto error;
       file_seek (file, file_ofs);
 
       if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
+        goto error;
       file_ofs += sizeof phdr;
       switch (phdr.p_type) 
         {
@@ -267,58 +640,48 @@ load (const char *file_name, void (**eip) (void), void **esp)
         case PT_DYNAMIC:
         case PT_INTERP:
         case PT_SHLIB:
-          goto done;
+          goto error;
         case PT_LOAD:
           if (validate_segment (&phdr, file)) 
             {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
+              struct elf_segment *seg = &image->segs[image->seg_cnt++];
               uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
+              seg->writable = (phdr.p_flags & PF_W) != 0;
+              seg->file_page = phdr.p_offset & ~PGMASK;
+              seg->mem_page = phdr.p_vaddr & ~PGMASK;
               if (phdr.p_filesz > 0)
                 {
                   /* Normal segment.
                      Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
+                  seg->read_bytes = page_offset + phdr.p_filesz;
+                  seg->zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz,
+                                               PGSIZE)
+                                     - seg->read_bytes);
                 }
               else 
                 {
                   /* Entirely zero.
                      Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
+                  seg->read_bytes = 0;
+                  seg->zero_bytes = ROUND_UP (page_offset + phdr.p_memsz,
+                                              PGSIZE);
                 }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                goto done;
             }
           else
-            goto done;
+            goto error;
           break;
         }
     }
+  return image;
 
-  /* Set up stack. */
-  if (!setup_stack (esp))
-    goto done;
-
-  /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
-
-  success = true;
-
- done:
-  /* We arrive here whether the load is successful or not. */
-  file_close (file);
-  return success;
+ error:
+  free (image);
+  return NULL;
 }
-
-/* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -377,6 +740,12 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   With VM, the pages are only recorded in the supplemental page
+   table, to be read in when they are first touched.  Otherwise,
+   if large pages are enabled, each 4 MB-aligned 4 MB run of the
+   segment is mapped with a single large page, falling back to
+   4 kB pages if the user pool has no suitably aligned memory.
+
    Return true if successful, false if a memory allocation error
    or disk read error occurs. */
 static bool
@@ -387,41 +756,122 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
-  file_seek (file, ofs);
+#ifdef VM
+  /* Just record where each page comes from.  page_fault() will
+     read it in when the process first touches it. */
   while (read_bytes > 0 || zero_bytes > 0) 
     {
-      /* Calculate how to fill this page.
-         We will read PAGE_READ_BYTES bytes from FILE
-         and zero the final PAGE_ZERO_BYTES bytes. */
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-      /* Get a page of memory. */
-      uint8_t *kpage = palloc_get_page (PAL_USER);
-      if (kpage == NULL)
+      if (!page_add_file (thread_current ()->pages, upage, file, ofs,
+                          page_read_bytes, writable))
         return false;
 
-      /* Load this page. */
-      if (file_read (file, kpage, page_read_bytes) != (int) page_read_bytes)
+      read_bytes -= page_read_bytes;
+      zero_bytes -= page_zero_bytes;
+      ofs += PGSIZE;
+      upage += PGSIZE;
+    }
+  return true;
+#else
+  void *kpages[LOAD_BATCH];
+  size_t page_cnt = 0;
+
+  file_seek (file, ofs);
+  while (read_bytes > 0 || zero_bytes > 0) 
+    {
+      if (process_large_pages && init_large_pages
+          && ((uintptr_t) upage & LGPGMASK) == 0
+          && read_bytes + zero_bytes >= PTSPAN)
         {
-          palloc_free_page (kpage);
-          return false; 
+          size_t lp_read_bytes = read_bytes < PTSPAN ? read_bytes : PTSPAN;
+          size_t lp_zero_bytes = PTSPAN - lp_read_bytes;
+          uint8_t *kpage = palloc_get_multiple_aligned (PAL_USER,
+                                                        PTSPAN / PGSIZE,
+                                                        PTSPAN / PGSIZE);
+          if (kpage != NULL)
+            {
+              if (file_read (file, kpage, lp_read_bytes)
+                  != (int) lp_read_bytes
+                  || !pagedir_set_large_page (thread_current ()->pagedir,
+                                              upage, kpage, writable))
+                {
+                  palloc_free_multiple (kpage, PTSPAN / PGSIZE);
+                  return false;
+                }
+              memset (kpage + lp_read_bytes, 0, lp_zero_bytes);
+
+              read_bytes -= lp_read_bytes;
+              zero_bytes -= lp_zero_bytes;
+              upage += PTSPAN;
+              continue;
+            }
         }
-      memset (kpage + page_read_bytes, 0, page_zero_bytes);
 
-      /* Add the page to the process's address space. */
-      if (!install_page (upage, kpage, writable)) 
+      /* Load up to LOAD_BATCH pages, stopping at the end of
+         the current page table, then map them all at once. */
+      page_cnt = 0;
+      do
         {
-          palloc_free_page (kpage);
-          return false; 
+          /* Calculate how to fill this page.
+             We will read PAGE_READ_BYTES bytes from FILE
+             and zero the final PAGE_ZERO_BYTES bytes. */
+          size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+          size_t page_zero_bytes = PGSIZE - page_read_bytes;
+
+          /* Get a page of memory. */
+          uint8_t *kpage = palloc_get_page (PAL_USER);
+          if (kpage == NULL)
+            goto fail;
+          kpages[page_cnt++] = kpage;
+
+          /* Load this page. */
+          if (file_read (file, kpage, page_read_bytes)
+              != (int) page_read_bytes)
+            goto fail;
+          memset (kpage + page_read_bytes, 0, page_zero_bytes);
+
+          /* Advance. */
+          read_bytes -= page_read_bytes;
+          zero_bytes -= page_zero_bytes;
         }
-
-      /* Advance. */
-      read_bytes -= page_read_bytes;
-      zero_bytes -= page_zero_bytes;
-      upage += PGSIZE;
+      while (page_cnt < LOAD_BATCH && (read_bytes > 0 || zero_bytes > 0)
+             && ((uintptr_t) (upage + page_cnt * PGSIZE) & LGPGMASK) != 0);
+
+      /* Add the pages to the process's address space. */
+      if (!pagedir_map_range (thread_current ()->pagedir, upage, kpages,
+                              page_cnt, writable))
+        goto fail;
+      upage += page_cnt * PGSIZE;
     }
   return true;
+
+ fail:
+  while (page_cnt > 0)
+    palloc_free_page (kpages[--page_cnt]);
+  return false;
+#endif /* !VM */
+}
+
+/* Maps the time page (see lib/timepage.h) read-only into the
+   current process at TIMEPAGE_ADDR.  The page belongs to the
+   timer, so process_exit() unmaps it before destroying the page
+   directory, which would otherwise free it.  Returns true if
+   successful, false if a segment of the executable is in the way
+   or if memory allocation fails. */
+static bool
+map_time_page (void)
+{
+  struct thread *t = thread_current ();
+
+#ifdef VM
+  if (page_lookup (t->pages, TIMEPAGE_ADDR) != NULL)
+    return false;
+#endif
+  return (pagedir_get_page (t->pagedir, TIMEPAGE_ADDR) == NULL
+          && pagedir_set_page (t->pagedir, TIMEPAGE_ADDR, timer_time_page (),
+                               false));
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
@@ -429,6 +879,18 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 setup_stack (void **esp) 
 {
+#ifdef VM
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+
+  if (page_add_file (thread_current ()->pages, upage, NULL, 0, 0, true)
+      && page_in (upage, true, NULL))
+    {
+      thread_current ()->stack_bottom = upage;
+      *esp = PHYS_BASE;
+      return true;
+    }
+  return false;
+#else
   uint8_t *kpage;
   bool success = false;
 
@@ -442,8 +904,51 @@ setup_stack (void **esp)
         palloc_free_page (kpage);
     }
   return success;
+#endif
+}
+
+/* Pushes the words of CMDLINE, separated by spaces, onto the new
+   user stack whose top is *ESP, followed by argv[] and argc
+   pointing to them and a null return address, as main() expects
+   to find them, and updates *ESP.  Returns true if successful,
+   false if the arguments do not fit in the stack's first page. */
+static bool
+push_args (const char *cmdline, void **esp)
+{
+  size_t len = strlen (cmdline) + 1;
+  char *args = (char *) *esp - len;
+  char **argv;
+  char *token, *save_ptr;
+  int argc = 0;
+  const char *cp;
+
+  /* Count the words. */
+  for (cp = cmdline; *cp != '\0'; cp++)
+    if (*cp != ' ' && (cp == cmdline || cp[-1] == ' '))
+      argc++;
+
+  /* Lay out the stack: the strings at the top, then argv[] with
+     its null terminator, word-aligned, then argv, argc, and the
+     return address. */
+  argv = (char **) ((uintptr_t) args & ~3) - (argc + 1);
+  if ((uint8_t *) (argv - 3) < (uint8_t *) *esp - PGSIZE)
+    return false;
+
+  strlcpy (args, cmdline, len);
+  argc = 0;
+  for (token = strtok_r (args, " ", &save_ptr); token != NULL;
+       token = strtok_r (NULL, " ", &save_ptr))
+    argv[argc++] = token;
+  argv[argc] = NULL;
+
+  argv[-1] = (char *) argv;
+  argv[-2] = (char *) (intptr_t) argc;
+  argv[-3] = NULL;
+  *esp = argv - 3;
+  return true;
 }
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -463,3 +968,4 @@ install_page (void *upage, void *kpage, bool writable)
   return (pagedir_get_page (t->pagedir, upage) == NULL
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
+#endif /* !VM */
@@ -3,7 +3,13 @@
 
 #include "threads/thread.h"
 
-tid_t process_execute (const char *file_name);
+struct intr_frame;
+
+extern bool process_large_pages;
+
+void process_init (void);
+tid_t process_execute (const char *cmdline);
+tid_t process_fork (const struct intr_frame *);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
@@ -1,20 +1,872 @@
 #include "userprog/syscall.h"
+#include <iovec.h>
+#include <limits.h>
 #include <stdio.h>
+#include <string.h>
 #include <syscall-nr.h>
+#include "devices/input.h"
+#include "devices/shutdown.h"
+#include "filesys/directory.h"
+#include "filesys/file.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/exception.h"
+#include "userprog/gdt.h"
+#include "userprog/ioring.h"
+#include "userprog/process.h"
+#include "userprog/tss.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
-static void syscall_handler (struct intr_frame *);
+/* Serializes access to the file system, which is not safe for
+   concurrent use. */
+struct lock filesys_lock;
 
+/* A system call handler.  ARGS holds the call's arguments as
+   passed by the user program.  F is the user's interrupt frame.
+   Returns the value to pass back in EAX. */
+typedef uint32_t syscall_func (const uint32_t args[], struct intr_frame *f);
+
+/* A system call. */
+struct syscall
+  {
+    syscall_func *func;         /* Handler. */
+    int arg_cnt;                /* Number of arguments. */
+  };
+
+static syscall_func sys_halt, sys_exit, sys_exec, sys_wait, sys_create,
+  sys_remove, sys_open, sys_filesize, sys_read, sys_write, sys_seek,
+  sys_tell, sys_close, sys_mmap, sys_munmap, sys_chdir, sys_mkdir,
+  sys_readdir, sys_isdir, sys_inumber, sys_fork, sys_madvise,
+  sys_faultstat, sys_readv, sys_writev, sys_pread, sys_pwrite,
+  sys_ioring_setup, sys_ioring_enter, sys_copy_file_range, sys_set_cloexec;
+
+/* System calls, indexed by number. */
+static const struct syscall syscall_table[] =
+  {
+    [SYS_HALT] = {sys_halt, 0},
+    [SYS_EXIT] = {sys_exit, 1},
+    [SYS_EXEC] = {sys_exec, 1},
+    [SYS_WAIT] = {sys_wait, 1},
+    [SYS_CREATE] = {sys_create, 2},
+    [SYS_REMOVE] = {sys_remove, 1},
+    [SYS_OPEN] = {sys_open, 1},
+    [SYS_FILESIZE] = {sys_filesize, 1},
+    [SYS_READ] = {sys_read, 3},
+    [SYS_WRITE] = {sys_write, 3},
+    [SYS_SEEK] = {sys_seek, 2},
+    [SYS_TELL] = {sys_tell, 1},
+    [SYS_CLOSE] = {sys_close, 1},
+    [SYS_MMAP] = {sys_mmap, 2},
+    [SYS_MUNMAP] = {sys_munmap, 1},
+    [SYS_CHDIR] = {sys_chdir, 1},
+    [SYS_MKDIR] = {sys_mkdir, 1},
+    [SYS_READDIR] = {sys_readdir, 2},
+    [SYS_ISDIR] = {sys_isdir, 1},
+    [SYS_INUMBER] = {sys_inumber, 1},
+    [SYS_FORK] = {sys_fork, 0},
+    [SYS_MADVISE] = {sys_madvise, 3},
+    [SYS_FAULTSTAT] = {sys_faultstat, 2},
+    [SYS_READV] = {sys_readv, 3},
+    [SYS_WRITEV] = {sys_writev, 3},
+    [SYS_PREAD] = {sys_pread, 4},
+    [SYS_PWRITE] = {sys_pwrite, 4},
+    [SYS_IORING_SETUP] = {sys_ioring_setup, 1},
+    [SYS_IORING_ENTER] = {sys_ioring_enter, 2},
+    [SYS_COPY_FILE_RANGE] = {sys_copy_file_range, 3},
+    [SYS_SET_CLOEXEC] = {sys_set_cloexec, 2},
+  };
+
+/* Number of entries in syscall_table. */
+#define SYSCALL_CNT (sizeof syscall_table / sizeof *syscall_table)
+
+/* Most arguments taken by any system call. */
+#define SYSCALL_MAX_ARGS 4
+
+/* Also called by sysenter_entry in sysenter.S. */
+void syscall_handler (struct intr_frame *);
+void sysenter_entry (void);
+
+static void kill_process (void) NO_RETURN;
+static bool user_range_ok (const void *, size_t);
+static void copy_in (void *dst, const void *usrc, size_t size);
+static bool copy_out (void *udst, const void *src, size_t size);
+static char *copy_in_string (const char *);
+static void verify_buffer (const void *, size_t, bool writable);
+static int write_console (const void *ubuf, size_t size);
+
+/* Sets up system call entry through "int $0x30" and, if the CPU
+   supports it, through SYSENTER, whose target is configured in
+   model-specific registers.  SYSENTER implies that the user code
+   and stack segments follow the kernel's in the GDT, as they do;
+   see [IA32-v2b] "SYSENTER". */
 void
-syscall_init (void) 
+syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+  lock_init (&filesys_lock);
+
+  if (cpu_has (CPUID_SEP | CPUID_MSR))
+    {
+      cpu_write_msr (MSR_SYSENTER_CS, SEL_KCSEG);
+      cpu_write_msr (MSR_SYSENTER_ESP, (uintptr_t) tss_get_esp0 ());
+      cpu_write_msr (MSR_SYSENTER_EIP, (uintptr_t) sysenter_entry);
+    }
 }
 
+/* System call handler.  The user stack holds the system call
+   number followed by its arguments. */
+void
+syscall_handler (struct intr_frame *f)
+{
+  const struct syscall *sc;
+  uint32_t args[SYSCALL_MAX_ARGS];
+  uint32_t nr;
+
+#ifdef VM
+  /* Page faults on user memory need the user stack pointer. */
+  thread_current ()->user_esp = f->esp;
+#endif
+
+  copy_in (&nr, f->esp, sizeof nr);
+  if (nr >= SYSCALL_CNT || syscall_table[nr].func == NULL)
+    kill_process ();
+  sc = &syscall_table[nr];
+
+  copy_in (args, (uint32_t *) f->esp + 1, sizeof *args * sc->arg_cnt);
+  f->eax = sc->func (args, f);
+}
+
+/* Terminates the current process with exit status -1. */
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+kill_process (void)
 {
-  printf ("system call!\n");
+  thread_current ()->exit_status = -1;
   thread_exit ();
 }
+
+/* User memory access.
+
+   Rather than checking every user pointer against the page
+   tables before using it, we simply access it.  If the address
+   is valid the access succeeds, possibly after a page fault
+   brings the page in.  If it is not, the page fault handler sees
+   a kernel access to a user address that it cannot resolve and,
+   instead of panicking, resumes at the address that get_user()
+   or put_user() stored in EAX, with -1 in EAX.  Thus only a bad
+   address costs more than the access itself.
+
+   The accessors live in usercopy.S, so that the page fault
+   handler can tell a fault in one of them from a fault anywhere
+   else in the kernel, which syscall_fixup() does not resume. */
+
+/* In usercopy.S. */
+extern const char usercopy_start[], usercopy_end[];
+int usercopy_get (const uint8_t *uaddr);
+int usercopy_put (uint8_t *udst, uint8_t byte);
+
+/* Reads a byte at user virtual address UADDR, which must be
+   below PHYS_BASE.  Returns the byte value if successful, -1 if
+   a page fault occurred. */
+static inline int
+get_user (const uint8_t *uaddr)
+{
+  return usercopy_get (uaddr);
+}
+
+/* Writes BYTE to user address UDST, which must be below
+   PHYS_BASE.  Returns true if successful, false if a page fault
+   occurred. */
+static inline bool
+put_user (uint8_t *udst, uint8_t byte)
+{
+  return usercopy_put (udst, byte) != -1;
+}
+
+/* Returns true if the SIZE bytes starting at UADDR all lie below
+   PHYS_BASE, false otherwise. */
+static bool
+user_range_ok (const void *uaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) uaddr;
+  return start <= (uintptr_t) PHYS_BASE
+         && size <= (uintptr_t) PHYS_BASE - start;
+}
+
+/* Checks that each page of the SIZE bytes at user address UADDR
+   of the current process can be read and, if WRITABLE is true,
+   written, by touching one byte in each.  Returns true if so,
+   false otherwise. */
+bool
+syscall_probe_user (const void *uaddr, size_t size, bool writable)
+{
+  uint8_t *p = (uint8_t *) uaddr;
+  uint8_t *end = p + size;
+
+  if (!user_range_ok (uaddr, size))
+    return false;
+  while (p < end)
+    {
+      int byte = get_user (p);
+      if (byte == -1 || (writable && !put_user (p, byte)))
+        return false;
+      p = (uint8_t *) pg_round_down (p) + PGSIZE;
+    }
+  return true;
+}
+
+/* Called by the page fault handler, with the interrupted frame
+   F, for a kernel access to a user address that it could not
+   resolve.  If get_user() or put_user() made the access, makes
+   it return -1 and returns true.  Otherwise returns false, and
+   the handler should call syscall_abort(). */
+bool
+syscall_fixup (struct intr_frame *f)
+{
+  const char *eip = (const char *) f->eip;
+
+  if (eip < usercopy_start || eip >= usercopy_end)
+    return false;
+  f->eip = (void (*) (void)) f->eax;
+  f->eax = 0xffffffff;
+  return true;
+}
+
+/* Terminates the current process after a fault that
+   syscall_fixup() did not resolve: a page of a buffer checked by
+   verify_buffer() that could not be brought back in, say for
+   lack of memory.  System calls hold no lock but filesys_lock
+   while they access user memory directly, so that is the only
+   one released. */
+void
+syscall_abort (void)
+{
+  if (lock_held_by_current_thread (&filesys_lock))
+    lock_release (&filesys_lock);
+  kill_process ();
+}
+
+/* Kills the process unless the SIZE bytes at user address UADDR
+   can be read and, if WRITABLE is true, written.  Afterward, the
+   kernel may access the buffer directly: the process has only
+   one thread, so nothing can unmap it in the meantime, and pages
+   that are evicted are simply faulted back in.  If one cannot
+   be, the process dies in syscall_abort(). */
+static void
+verify_buffer (const void *uaddr, size_t size, bool writable)
+{
+  if (!syscall_probe_user (uaddr, size, writable))
+    kill_process ();
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Kills the process if any of the user bytes are not
+   valid. */
+static void
+copy_in (void *dst, const void *usrc, size_t size)
+{
+  verify_buffer (usrc, size, false);
+  memcpy (dst, usrc, size);
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns true if successful, false if any of the user
+   bytes are not writable. */
+static bool
+copy_out (void *udst, const void *src, size_t size)
+{
+  if (!syscall_probe_user (udst, size, true))
+    return false;
+  memcpy (udst, src, size);
+  return true;
+}
+
+/* Copies the null-terminated string at user address USTR of the
+   current process into the SIZE bytes at DST.  Returns true if
+   successful, false if the string is not in valid user memory or
+   if it does not fit. */
+bool
+syscall_copy_string (char *dst, const char *ustr, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      int c = is_user_vaddr (ustr + i) ? get_user ((uint8_t *) ustr + i) : -1;
+      if (c == -1)
+        return false;
+      dst[i] = c;
+      if (c == '\0')
+        return true;
+    }
+  return false;
+}
+
+/* Copies the null-terminated string at user address USTR into a
+   new page and returns it.  The caller must free the page with
+   palloc_free_page().  Kills the process if the string is not in
+   valid user memory, if it is longer than a page, or if memory
+   allocation fails. */
+static char *
+copy_in_string (const char *ustr)
+{
+  char *kstr = palloc_get_page (0);
+
+  if (kstr == NULL)
+    kill_process ();
+  if (!syscall_copy_string (kstr, ustr, PGSIZE))
+    {
+      palloc_free_page (kstr);
+      kill_process ();
+    }
+  return kstr;
+}
+
+/* Acquires filesys_lock, which also protects the file
+   descriptor table, and returns the current process's open file
+   with descriptor FD.  Kills the process if there is none. */
+static struct file *
+lock_file (int fd)
+{
+  struct file *file;
+
+  lock_acquire (&filesys_lock);
+  file = fd_table_get (&thread_current ()->fds, fd);
+  if (file == NULL)
+    {
+      lock_release (&filesys_lock);
+      kill_process ();
+    }
+  return file;
+}
+
+/* Halt system call. */
+static uint32_t
+sys_halt (const uint32_t args[] UNUSED, struct intr_frame *f UNUSED)
+{
+  shutdown_power_off ();
+}
+
+/* Exit system call. */
+static uint32_t
+sys_exit (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  thread_current ()->exit_status = args[0];
+  thread_exit ();
+}
+
+/* Exec system call. */
+static uint32_t
+sys_exec (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  char *cmdline = copy_in_string ((const char *) args[0]);
+  tid_t tid = process_execute (cmdline);
+
+  palloc_free_page (cmdline);
+  return tid;
+}
+
+/* Wait system call. */
+static uint32_t
+sys_wait (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return process_wait (args[0]);
+}
+
+/* Create system call. */
+static uint32_t
+sys_create (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  char *name = copy_in_string ((const char *) args[0]);
+  bool success;
+
+  lock_acquire (&filesys_lock);
+  success = filesys_create (name, args[1]);
+  lock_release (&filesys_lock);
+  palloc_free_page (name);
+  return success;
+}
+
+/* Remove system call. */
+static uint32_t
+sys_remove (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  char *name = copy_in_string ((const char *) args[0]);
+  bool success;
+
+  lock_acquire (&filesys_lock);
+  success = filesys_remove (name);
+  lock_release (&filesys_lock);
+  palloc_free_page (name);
+  return success;
+}
+
+/* Open system call. */
+static uint32_t
+sys_open (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  char *name = copy_in_string ((const char *) args[0]);
+  struct file *file;
+  int fd = -1;
+
+  lock_acquire (&filesys_lock);
+  file = filesys_open (name);
+  if (file != NULL
+      && (fd = fd_table_add (&thread_current ()->fds, file, true)) < 0)
+    file_close (file);
+  lock_release (&filesys_lock);
+  palloc_free_page (name);
+  return fd;
+}
+
+/* Filesize system call. */
+static uint32_t
+sys_filesize (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *file = lock_file (args[0]);
+  off_t size;
+
+  size = file_length (file);
+  lock_release (&filesys_lock);
+  return size;
+}
+
+/* Read system call. */
+static uint32_t
+sys_read (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  int fd = args[0];
+  uint8_t *buffer = (uint8_t *) args[1];
+  unsigned size = args[2];
+  struct file *file;
+  off_t bytes_read;
+
+  verify_buffer (buffer, size, true);
+  if (fd == STDIN_FILENO)
+    {
+      unsigned i;
+
+      for (i = 0; i < size; i++)
+        buffer[i] = input_getc ();
+      return size;
+    }
+
+  file = lock_file (fd);
+  bytes_read = file_read (file, buffer, size);
+  lock_release (&filesys_lock);
+  return bytes_read;
+}
+
+/* Write system call. */
+static uint32_t
+sys_write (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  int fd = args[0];
+  const void *buffer = (const void *) args[1];
+  unsigned size = args[2];
+  struct file *file;
+  off_t bytes_written;
+
+  verify_buffer (buffer, size, false);
+  if (fd == STDOUT_FILENO)
+    return write_console (buffer, size);
+
+  file = lock_file (fd);
+  bytes_written = file_write (file, buffer, size);
+  lock_release (&filesys_lock);
+  return bytes_written;
+}
+
+/* Seek system call. */
+static uint32_t
+sys_seek (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *file = lock_file (args[0]);
+
+  file_seek (file, args[1]);
+  lock_release (&filesys_lock);
+  return 0;
+}
+
+/* Tell system call. */
+static uint32_t
+sys_tell (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *file = lock_file (args[0]);
+  off_t position;
+
+  position = file_tell (file);
+  lock_release (&filesys_lock);
+  return position;
+}
+
+/* Close system call. */
+static uint32_t
+sys_close (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  lock_acquire (&filesys_lock);
+  fd_table_close (&thread_current ()->fds, args[0]);
+  lock_release (&filesys_lock);
+  return 0;
+}
+
+/* Mmap system call. */
+static uint32_t
+sys_mmap (const uint32_t args[] UNUSED, struct intr_frame *f UNUSED)
+{
+#ifdef VM
+  mapid_t mapid;
+
+  lock_acquire (&filesys_lock);
+  mapid = mmap_map (fd_table_get (&thread_current ()->fds, args[0]),
+                    (void *) args[1]);
+  lock_release (&filesys_lock);
+  return mapid;
+#else
+  return -1;
+#endif
+}
+
+/* Munmap system call. */
+static uint32_t
+sys_munmap (const uint32_t args[] UNUSED, struct intr_frame *f UNUSED)
+{
+#ifdef VM
+  mmap_unmap (args[0]);
+#endif
+  return 0;
+}
+
+/* Chdir system call.  The file system has only a root directory,
+   so there is nothing to change to. */
+static uint32_t
+sys_chdir (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  palloc_free_page (copy_in_string ((const char *) args[0]));
+  return false;
+}
+
+/* Mkdir system call.  The file system has only a root
+   directory, so this always fails. */
+static uint32_t
+sys_mkdir (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  palloc_free_page (copy_in_string ((const char *) args[0]));
+  return false;
+}
+
+/* Readdir system call.  File descriptors never refer to
+   directories, so this always fails. */
+static uint32_t
+sys_readdir (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  verify_buffer ((void *) args[1], NAME_MAX + 1, true);
+  lock_file (args[0]);
+  lock_release (&filesys_lock);
+  return false;
+}
+
+/* Isdir system call.  File descriptors never refer to
+   directories. */
+static uint32_t
+sys_isdir (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  lock_file (args[0]);
+  lock_release (&filesys_lock);
+  return false;
+}
+
+/* Inumber system call. */
+static uint32_t
+sys_inumber (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *file = lock_file (args[0]);
+  block_sector_t inumber = inode_get_inumber (file_get_inode (file));
+
+  lock_release (&filesys_lock);
+  return inumber;
+}
+
+/* Fork system call. */
+static uint32_t
+sys_fork (const uint32_t args[] UNUSED, struct intr_frame *f)
+{
+  return process_fork (f);
+}
+
+/* Madvise system call. */
+static uint32_t
+sys_madvise (const uint32_t args[] UNUSED, struct intr_frame *f UNUSED)
+{
+#ifdef VM
+  return page_advise ((void *) args[0], args[1], args[2]);
+#else
+  return false;
+#endif
+}
+
+/* Faultstat system call. */
+static uint32_t
+sys_faultstat (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct fault_stats *stats;
+  bool success;
+
+  /* Too big for the kernel stack, given that copy_out() may page
+     fault into eviction and disk I/O. */
+  stats = malloc (sizeof *stats);
+  if (stats == NULL)
+    return false;
+  exception_get_fault_stats (args[0], stats);
+  success = copy_out ((void *) args[1], stats, sizeof *stats);
+  free (stats);
+  return success;
+}
+
+/* Copies the I/O vector of CNT buffers at user address UIOV into
+   IOV and checks that each buffer can be read and, if WRITABLE
+   is true, written.  Returns the buffers' total length, or -1 if
+   CNT is not between 0 and IOV_MAX or the total length does not
+   fit in an int.  Kills the process if any of the user memory is
+   not valid. */
+static int
+copy_in_iov (struct iovec iov[IOV_MAX], const struct iovec *uiov, int cnt,
+             bool writable)
+{
+  size_t total = 0;
+  int i;
+
+  if (cnt < 0 || cnt > IOV_MAX)
+    return -1;
+  copy_in (iov, uiov, sizeof *iov * cnt);
+  for (i = 0; i < cnt; i++)
+    {
+      verify_buffer (iov[i].iov_base, iov[i].iov_len, writable);
+      if (iov[i].iov_len > INT_MAX - total)
+        return -1;
+      total += iov[i].iov_len;
+    }
+  return total;
+}
+
+/* Readv system call. */
+static uint32_t
+sys_readv (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  int fd = args[0];
+  struct iovec iov[IOV_MAX];
+  int cnt = args[2];
+  struct file *file;
+  off_t bytes_read;
+  int total;
+
+  total = copy_in_iov (iov, (const struct iovec *) args[1], cnt, true);
+  if (total < 0)
+    return -1;
+  if (fd == STDIN_FILENO)
+    {
+      int i;
+      size_t j;
+
+      for (i = 0; i < cnt; i++)
+        for (j = 0; j < iov[i].iov_len; j++)
+          ((uint8_t *) iov[i].iov_base)[j] = input_getc ();
+      return total;
+    }
+
+  file = lock_file (fd);
+  bytes_read = file_readv (file, iov, cnt);
+  lock_release (&filesys_lock);
+  return bytes_read;
+}
+
+/* Writev system call. */
+static uint32_t
+sys_writev (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  int fd = args[0];
+  struct iovec iov[IOV_MAX];
+  int cnt = args[2];
+  struct file *file;
+  off_t bytes_written;
+  int total;
+
+  total = copy_in_iov (iov, (const struct iovec *) args[1], cnt, false);
+  if (total < 0)
+    return -1;
+  if (fd == STDOUT_FILENO)
+    {
+      int i;
+
+      for (i = 0; i < cnt; i++)
+        if (write_console (iov[i].iov_base, iov[i].iov_len) < 0)
+          return -1;
+      return total;
+    }
+
+  file = lock_file (fd);
+  bytes_written = file_writev (file, iov, cnt);
+  lock_release (&filesys_lock);
+  return bytes_written;
+}
+
+/* Pread system call.  Unlike read, it leaves the file position
+   alone. */
+static uint32_t
+sys_pread (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  void *buffer = (void *) args[1];
+  unsigned size = args[2];
+  off_t position = args[3];
+  struct file *file;
+  off_t bytes_read;
+
+  verify_buffer (buffer, size, true);
+  if (position < 0)
+    return -1;
+
+  file = lock_file (args[0]);
+  bytes_read = file_read_at (file, buffer, size, position);
+  lock_release (&filesys_lock);
+  return bytes_read;
+}
+
+/* Pwrite system call.  Unlike write, it leaves the file position
+   alone. */
+static uint32_t
+sys_pwrite (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  const void *buffer = (const void *) args[1];
+  unsigned size = args[2];
+  off_t position = args[3];
+  struct file *file;
+  off_t bytes_written;
+
+  verify_buffer (buffer, size, false);
+  if (position < 0)
+    return -1;
+
+  file = lock_file (args[0]);
+  bytes_written = file_write_at (file, buffer, size, position);
+  lock_release (&filesys_lock);
+  return bytes_written;
+}
+
+/* Ioring_setup system call. */
+static uint32_t
+sys_ioring_setup (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return (uint32_t) ioring_setup ((void *) args[0]);
+}
+
+/* Ioring_enter system call. */
+static uint32_t
+sys_ioring_enter (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  return ioring_enter (args[0], args[1]);
+}
+
+/* Writes the SIZE bytes at user address UBUF, which the caller
+   has checked, to the console, through a kernel buffer: putbuf()
+   holds the console lock while it reads, and a process that died
+   of a fault there would never release it.  Returns SIZE, or -1
+   if memory allocation fails. */
+static int
+write_console (const void *ubuf, size_t size)
+{
+  const uint8_t *p = ubuf;
+  uint8_t *buffer;
+  size_t left;
+
+  if (size == 0)
+    return 0;
+  buffer = palloc_get_page (0);
+  if (buffer == NULL)
+    return -1;
+  for (left = size; left > 0; )
+    {
+      size_t chunk = left < PGSIZE ? left : PGSIZE;
+      memcpy (buffer, p, chunk);
+      putbuf ((const char *) buffer, chunk);
+      p += chunk;
+      left -= chunk;
+    }
+  palloc_free_page (buffer);
+  return size;
+}
+
+/* Copies up to SIZE bytes from IN to the console, through a
+   kernel buffer, starting at IN's current position and
+   advancing it.  Returns the number of bytes copied.  The caller
+   must hold filesys_lock. */
+static off_t
+copy_to_console (struct file *in, off_t size)
+{
+  uint8_t *buffer = palloc_get_page (0);
+  off_t bytes_copied = 0;
+
+  if (buffer == NULL)
+    return -1;
+  while (size > 0)
+    {
+      off_t chunk = file_read (in, buffer, size < PGSIZE ? size : PGSIZE);
+      if (chunk <= 0)
+        break;
+      putbuf ((const char *) buffer, chunk);
+      size -= chunk;
+      bytes_copied += chunk;
+    }
+  palloc_free_page (buffer);
+  return bytes_copied;
+}
+
+/* Copy_file_range system call.  Copies from one open file to
+   another, or to the console, inside the kernel, so that the
+   data never passes through user memory. */
+static uint32_t
+sys_copy_file_range (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  struct file *in = lock_file (args[0]);
+  int out_fd = args[1];
+  off_t size = args[2] < INT_MAX ? (off_t) args[2] : INT_MAX;
+  off_t bytes_copied;
+
+  if (out_fd == STDOUT_FILENO)
+    bytes_copied = copy_to_console (in, size);
+  else
+    {
+      struct file *out = fd_table_get (&thread_current ()->fds, out_fd);
+      if (out == NULL)
+        {
+          lock_release (&filesys_lock);
+          kill_process ();
+        }
+      bytes_copied = file_copy (out, in, size);
+    }
+  lock_release (&filesys_lock);
+  return bytes_copied;
+}
+
+/* Set_cloexec system call.  Descriptors start out closed by
+   exec(); clearing the flag passes one on to programs that this
+   process starts. */
+static uint32_t
+sys_set_cloexec (const uint32_t args[], struct intr_frame *f UNUSED)
+{
+  bool success;
+
+  lock_acquire (&filesys_lock);
+  success = fd_table_set_cloexec (&thread_current ()->fds, args[0],
+                                  args[1] != 0);
+  lock_release (&filesys_lock);
+  return success;
+}
@@ -1,6 +1,19 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <debug.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+struct intr_frame;
+
+extern struct lock filesys_lock;
+
 void syscall_init (void);
+bool syscall_probe_user (const void *uaddr, size_t size, bool writable);
+bool syscall_copy_string (char *dst, const char *ustr, size_t size);
+bool syscall_fixup (struct intr_frame *);
+void syscall_abort (void) NO_RETURN;
 
 #endif /* userprog/syscall.h */
@@ -0,0 +1,789 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/ksm.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/* Frame table.
+
+   Every page of the user pool that holds a user page is
+   described by a struct frame in the frame table.  When the
+   user pool runs out, frame_alloc() picks a victim with the
+   "clock" (second chance) algorithm: the clock hand sweeps the
+   table, clearing the accessed bit of each page it passes, and
+   stops at the first page whose accessed bit was already clear.
+   It keeps going until it has found swap_cluster such pages,
+   which page_out_cluster() evicts together, so that the dirty
+   ones go to swap in a single run of slots.  The first frame
+   freed this way is handed to the new page; the rest are kept
+   on a free list for the allocations that follow.
+
+   Frames that hold pages of files that processes share are also
+   kept in a hash table, the file page cache, so that a fault on
+   such a page can find a frame that already holds it.  A frame
+   leaves the cache when it is evicted or freed.  Writes to a
+   file through the file system are copied into the cached
+   frames of the pages they touch with frame_write_file(), so
+   that processes that map the file see them and do not write
+   older data back over them later.
+
+   A frame shared by several pages after fork() counts as
+   accessed if any of them was accessed, and evicting it unmaps
+   it from all of them.
+
+   Each process's resident set size (RSS), the number of its
+   pages in frames other than the zero frame, is kept up to date
+   as pages enter and leave frames.  Each process also has an
+   allotment of frames that follows its page fault frequency
+   (PFF): every PFF_INTERVAL, frame_fault() compares the number
+   of faults the process took with PFF_HIGH and PFF_LOW and
+   grows or shrinks its allotment to match.  Allotments may not
+   add up to more frames than the frame table has, so a process
+   that faults heavily can only grow into memory that others do
+   not claim, and the allotments of processes that fault rarely
+   shrink over time to make room.  When the user pool runs out,
+   the clock first looks for victims among the frames of
+   processes whose RSS exceeds their allotment, and only then
+   among all frames, so that one process that touches a lot of
+   memory cannot push out everyone else's working set.  A
+   process at the hard limit rss_max_pages evicts its own pages
+   to make room for new ones.
+
+   Paging is serialized by frame_lock, which is held while a
+   victim is chosen and written to swap.  Modified pages of
+   memory-mapped files go back to their files instead, which
+   frame_alloc() does with page_write_back() after it releases
+   frame_lock (see vm/page.c).  A frame is pinned while
+   its page is being read in, so that it cannot be chosen as a
+   victim before it is mapped, and while it is being copied for
+   copy-on-write. */
+
+/* Frames in use, in clock order. */
+static struct list frame_list;
+
+/* Frames freed by eviction but not yet reused. */
+static struct list free_list;
+
+/* File page cache: frames that hold shared file pages, keyed
+   by inode sector and offset. */
+static struct hash file_cache;
+
+/* A frame that holds all zeros.  Permanently pinned. */
+static struct frame zero_frame;
+
+/* Clock hand: next frame to consider for eviction, or the end
+   of frame_list. */
+static struct list_elem *hand;
+
+/* Next frame for the same-page merging thread to visit, or the
+   end of frame_list. */
+static struct list_elem *scan_hand;
+
+struct lock frame_lock;
+
+/* Maximum resident set size of a process, in pages.
+   Controlled by kernel command-line option "-rss". */
+size_t rss_max_pages = SIZE_MAX;
+
+/* Page fault frequency sampling: length of a sampling interval,
+   in timer ticks, and numbers of faults per interval above which
+   a process's allotment grows and below which it shrinks. */
+#define PFF_INTERVAL (TIMER_FREQ / 10)
+#define PFF_HIGH 32
+#define PFF_LOW 4
+
+/* Smallest allotment, and smallest amount to grow one by. */
+#define ALLOT_MIN 16
+#define ALLOT_STEP 8
+
+/* Frames in the frame table, sum of all processes' allotments,
+   and number of processes whose RSS exceeds their allotment. */
+static size_t frame_cnt;
+static size_t allot_total;
+static size_t over_cnt;
+
+/* Kinds of frames that evict() may choose. */
+enum victim_class
+  {
+    VICTIM_OWN,                 /* Only pages of the given process. */
+    VICTIM_OVER,                /* Only pages of processes over allotment. */
+    VICTIM_ANY                  /* Any frame. */
+  };
+
+/* Statistics. */
+static long long evict_cnt;             /* Pages evicted. */
+static long long sweep_cnt;             /* Frames passed by the hand. */
+static long long evict_pass_cnt;        /* Eviction passes. */
+static long long cache_hit_cnt;         /* File page cache hits. */
+static long long cache_write_cnt;       /* Cached pages updated by writes. */
+static long long own_evict_cnt;         /* Evicted for own hard limit. */
+static long long over_evict_cnt;        /* Evicted from over allotment. */
+static long long pff_grow_cnt;          /* Allotments grown. */
+static long long pff_shrink_cnt;        /* Allotments shrunk. */
+
+static struct frame *get_frame (bool may_evict);
+static struct frame *evict (enum victim_class, struct thread *);
+static bool is_victim (struct frame *, enum victim_class, struct thread *);
+static void set_allot (struct thread *, size_t);
+static void update_over (struct thread *);
+static bool test_and_clear_accessed (struct frame *);
+static void uncache (struct frame *);
+static struct frame *find_file (block_sector_t sector, off_t ofs,
+                                uint32_t read_bytes);
+static hash_hash_func file_cache_hash;
+static hash_less_func file_cache_less;
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  list_init (&frame_list);
+  list_init (&free_list);
+  if (!hash_init (&file_cache, file_cache_hash, file_cache_less, NULL))
+    PANIC ("frame: out of memory");
+  zero_frame.kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+  if (zero_frame.kpage == NULL)
+    PANIC ("frame: no memory for zero frame");
+  list_init (&zero_frame.pages);
+  zero_frame.pin_cnt = 1;
+  zero_frame.cached = false;
+  lock_init (&frame_lock);
+  hand = scan_hand = list_end (&frame_list);
+}
+
+/* Obtains a frame, evicting other pages if the user pool is
+   exhausted.  The frame is returned pinned and without pages;
+   the caller should fill it, add its page with
+   frame_add_page(), map it, and then call frame_unpin().
+   Returns a null pointer if no frame can be found.  The caller
+   must not hold frame_lock. */
+struct frame *
+frame_alloc (void)
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  f = get_frame (true);
+  lock_release (&frame_lock);
+
+  /* Eviction passes over modified pages of memory-mapped files
+     and leaves them for us to write back.  If it found nothing
+     else, try again now that they are clean. */
+  if (page_write_back () && f == NULL)
+    {
+      lock_acquire (&frame_lock);
+      f = get_frame (true);
+      lock_release (&frame_lock);
+    }
+  return f;
+}
+
+/* Like frame_alloc(), but returns a null pointer instead of
+   evicting a page.  Used for reading ahead, which should only
+   use memory that is otherwise idle. */
+struct frame *
+frame_try_alloc (void)
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  f = get_frame (false);
+  lock_release (&frame_lock);
+
+  return f;
+}
+
+/* Keeps F from being evicted until a matching call to
+   frame_unpin().  The caller must hold frame_lock. */
+void
+frame_pin (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  f->pin_cnt++;
+}
+
+/* Undoes one frame_pin(), or the pin on a newly allocated
+   frame.  The caller must hold frame_lock. */
+void
+frame_unpin (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (f->pin_cnt > 0);
+  f->pin_cnt--;
+}
+
+/* Records that page P is in frame F.  The caller must hold
+   frame_lock. */
+void
+frame_add_page (struct frame *f, struct page *p)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  list_push_back (&f->pages, &p->frame_elem);
+  p->frame = f;
+  if (f != &zero_frame)
+    {
+      p->owner->rss++;
+      update_over (p->owner);
+    }
+}
+
+/* Records that page P, which must be unmapped, is no longer in
+   frame F.  The caller must hold frame_lock and should free F
+   if no pages remain in it and it is not pinned. */
+void
+frame_remove_page (struct frame *f, struct page *p)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (p->frame == f);
+  list_remove (&p->frame_elem);
+  p->frame = NULL;
+  if (f != &zero_frame)
+    {
+      ASSERT (p->owner->rss > 0);
+      p->owner->rss--;
+      update_over (p->owner);
+    }
+}
+
+/* Records a page fault taken by the current process, which is
+   about to bring a page into memory, and adjusts its allotment
+   at the end of each PFF sampling interval.  The caller must
+   hold frame_lock. */
+void
+frame_fault (void)
+{
+  struct thread *t = thread_current ();
+  int64_t now = timer_ticks ();
+  int64_t elapsed;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (t->rss_allot == 0)
+    {
+      set_allot (t, ALLOT_MIN);
+      t->pff_start = now;
+      t->pff_faults = 0;
+    }
+  t->pff_faults++;
+
+  elapsed = now - t->pff_start;
+  if (elapsed < PFF_INTERVAL)
+    return;
+
+  /* Scale the count to one interval, since a process that
+     faulted rarely may not have faulted for many of them. */
+  if ((int64_t) t->pff_faults * PFF_INTERVAL > PFF_HIGH * elapsed)
+    {
+      size_t step = t->rss_allot / 4 > ALLOT_STEP ? t->rss_allot / 4
+                                                  : ALLOT_STEP;
+      size_t room = frame_cnt > allot_total ? frame_cnt - allot_total : 0;
+      size_t allot = t->rss_allot + (step < room ? step : room);
+
+      if (allot > rss_max_pages)
+        allot = rss_max_pages;
+      if (allot > t->rss_allot)
+        {
+          set_allot (t, allot);
+          pff_grow_cnt++;
+        }
+    }
+  else if ((int64_t) t->pff_faults * PFF_INTERVAL < PFF_LOW * elapsed)
+    {
+      /* Shrink to a little more than what the process actually
+         has in memory, if that is less. */
+      size_t allot = t->rss < t->rss_allot ? t->rss : t->rss_allot;
+      allot -= allot / 8;
+      if (allot < ALLOT_MIN)
+        allot = ALLOT_MIN;
+      if (allot < t->rss_allot)
+        {
+          set_allot (t, allot);
+          pff_shrink_cnt++;
+        }
+    }
+  t->pff_start = now;
+  t->pff_faults = 0;
+}
+
+/* Gives up the current process's allotment, when it exits.  The
+   caller must hold frame_lock. */
+void
+frame_release_allot (void)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  set_allot (thread_current (), 0);
+}
+
+/* Moves F to the clock hand and clears its pages' accessed bits,
+   so that F is the next frame evicted unless it is used again
+   first.  The caller must hold frame_lock. */
+void
+frame_deactivate (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (f == &zero_frame || f->pin_cnt > 0)
+    return;
+  test_and_clear_accessed (f);
+  if (hand != &f->elem)
+    {
+      if (scan_hand == &f->elem)
+        scan_hand = list_next (scan_hand);
+      list_remove (&f->elem);
+      list_insert (hand, &f->elem);
+      hand = &f->elem;
+    }
+}
+
+/* Returns true if more than one page is in frame F, or if F is
+   the zero frame, so that F may not be written. */
+bool
+frame_is_shared (struct frame *f)
+{
+  return (f == &zero_frame
+          || (!list_empty (&f->pages)
+              && list_front (&f->pages) != list_back (&f->pages)));
+}
+
+/* Returns the zero frame. */
+struct frame *
+frame_zero (void)
+{
+  return &zero_frame;
+}
+
+/* Returns the number of pages in the zero frame.  The caller
+   must hold frame_lock, unless it only wants an estimate. */
+size_t
+frame_zero_cnt (void)
+{
+  return list_size (&zero_frame.pages);
+}
+
+/* Returns the frame in the file page cache that holds the page
+   made of READ_BYTES bytes at offset OFS in the file with INODE,
+   followed by zeros, or a null pointer if there is none.  The
+   caller must hold frame_lock. */
+struct frame *
+frame_lookup_file (struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+  struct frame *f;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  f = find_file (inode_get_inumber (inode), ofs, read_bytes);
+  if (f != NULL)
+    cache_hit_cnt++;
+  return f;
+}
+
+/* Enters F, which must hold the page made of READ_BYTES bytes at
+   offset OFS in the file with INODE, into the file page cache.
+   Returns a null pointer if successful.  If another frame
+   already holds that page, returns that frame instead and leaves
+   F alone.  The caller must hold frame_lock. */
+struct frame *
+frame_insert_file (struct frame *f, struct inode *inode, off_t ofs,
+                   uint32_t read_bytes)
+{
+  struct hash_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (!f->cached);
+
+  f->sector = inode_get_inumber (inode);
+  f->ofs = ofs;
+  f->read_bytes = read_bytes;
+  e = hash_insert (&file_cache, &f->hash_elem);
+  if (e != NULL)
+    return hash_entry (e, struct frame, hash_elem);
+  f->cached = true;
+  return NULL;
+}
+
+/* Copies the SIZE bytes in DATA, which were just written to the
+   file with INODE at offset OFS, into the frames in the file
+   page cache that hold the pages they fall in.  Only pages laid
+   out as mmap_map() lays them out are looked for: the cache's
+   other pages belong to executables, which cannot be written
+   while they run.  The caller must hold filesys_lock, which
+   keeps the pages from being read in meanwhile, and must not
+   hold frame_lock, since DATA may be in user memory. */
+void
+frame_write_file (struct inode *inode, off_t ofs, const void *data,
+                  off_t size)
+{
+  block_sector_t sector = inode_get_inumber (inode);
+  off_t length = inode_length (inode);
+  const uint8_t *src = data;
+  off_t end = ofs + size;
+  off_t page_ofs;
+
+  ASSERT (!lock_held_by_current_thread (&frame_lock));
+
+  for (page_ofs = ofs - ofs % PGSIZE; page_ofs < end; page_ofs += PGSIZE)
+    {
+      uint32_t read_bytes = (length - page_ofs < PGSIZE
+                             ? length - page_ofs : PGSIZE);
+      off_t start = page_ofs > ofs ? page_ofs : ofs;
+      off_t stop = (page_ofs + (off_t) read_bytes < end
+                    ? page_ofs + (off_t) read_bytes : end);
+      uint8_t *dst;
+      struct frame *f;
+
+      lock_acquire (&frame_lock);
+      f = find_file (sector, page_ofs, read_bytes);
+      if (f != NULL)
+        frame_pin (f);
+      lock_release (&frame_lock);
+      if (f == NULL)
+        continue;
+
+      /* Writing F back to the file copies it onto itself. */
+      dst = (uint8_t *) f->kpage + (start - page_ofs);
+      if (dst != src + (start - ofs) && stop > start)
+        {
+          memcpy (dst, src + (start - ofs), stop - start);
+          cache_write_cnt++;
+        }
+
+      lock_acquire (&frame_lock);
+      frame_unpin (f);
+      frame_free_if_unused (f);
+      lock_release (&frame_lock);
+    }
+}
+
+/* Returns the next frame in the frame table for the same-page
+   merging thread to visit, cycling through the table, or a null
+   pointer if the table is empty.  The caller must hold
+   frame_lock. */
+struct frame *
+frame_scan_next (void)
+{
+  struct frame *f;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (scan_hand == list_end (&frame_list))
+    scan_hand = list_begin (&frame_list);
+  if (scan_hand == list_end (&frame_list))
+    return NULL;
+  f = list_entry (scan_hand, struct frame, elem);
+  scan_hand = list_next (scan_hand);
+  return f;
+}
+
+/* Removes F from the frame table and frees it.  The caller must
+   hold frame_lock and must already have removed F's pages. */
+void
+frame_free (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (list_empty (&f->pages));
+
+  uncache (f);
+  ksm_forget (f);
+  if (hand == &f->elem)
+    hand = list_next (hand);
+  if (scan_hand == &f->elem)
+    scan_hand = list_next (scan_hand);
+  list_remove (&f->elem);
+  palloc_free_page (f->kpage);
+  free (f);
+  frame_cnt--;
+}
+
+/* Frees F if no page is in it and it is not pinned.  The caller
+   must hold frame_lock. */
+void
+frame_free_if_unused (struct frame *f)
+{
+  if (list_empty (&f->pages) && f->pin_cnt == 0)
+    frame_free (f);
+}
+
+/* Prints frame table statistics. */
+void
+frame_print_stats (void)
+{
+  printf ("Frame: %zu frames in use, %zu free, %lld evictions in %lld passes, "
+          "%lld clock steps\n",
+          list_size (&frame_list), list_size (&free_list),
+          evict_cnt, evict_pass_cnt, sweep_cnt);
+  printf ("Frame: %zu shared file pages cached, %lld cache hits, "
+          "%lld updated by writes\n",
+          hash_size (&file_cache), cache_hit_cnt, cache_write_cnt);
+  printf ("Frame: %lld frames evicted from processes over allotment, "
+          "%lld at their RSS limit; %lld allotments grown, %lld shrunk\n",
+          over_evict_cnt, own_evict_cnt, pff_grow_cnt, pff_shrink_cnt);
+}
+
+/* Returns a pinned frame in the frame table, taking it from the
+   free list or the user pool or, if MAY_EVICT is true, by
+   evicting pages.  If the current process is at its RSS limit,
+   evicts one of its own pages instead, or fails if MAY_EVICT is
+   false.  Returns a null pointer on failure.  The caller must
+   hold frame_lock. */
+static struct frame *
+get_frame (bool may_evict)
+{
+  struct thread *t = thread_current ();
+  struct frame *f = NULL;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (t->rss >= rss_max_pages)
+    {
+      if (!may_evict)
+        return NULL;
+      f = evict (VICTIM_OWN, t);
+    }
+
+  if (f != NULL)
+    ;
+  else if (!list_empty (&free_list))
+    {
+      f = list_entry (list_pop_front (&free_list), struct frame, elem);
+      list_insert (hand, &f->elem);
+    }
+  else
+    {
+      void *kpage = palloc_get_page (PAL_USER);
+      if (kpage != NULL)
+        {
+          f = malloc (sizeof *f);
+          if (f != NULL)
+            {
+              f->kpage = kpage;
+              f->cached = false;
+              list_init (&f->pages);
+              list_insert (hand, &f->elem);
+              frame_cnt++;
+            }
+          else
+            palloc_free_page (kpage);
+        }
+      else if (may_evict)
+        {
+          if (over_cnt > 0)
+            f = evict (VICTIM_OVER, NULL);
+          if (f == NULL)
+            f = evict (VICTIM_ANY, NULL);
+        }
+    }
+
+  if (f != NULL)
+    {
+      f->pin_cnt = 1;
+      f->ksm_checked = f->ksm_stable = f->ksm_merged = false;
+    }
+  return f;
+}
+
+/* Chooses up to swap_cluster victim frames of class CLASS (with
+   owner T, for VICTIM_OWN) with the clock algorithm and evicts
+   their pages.  Returns one of the freed frames, still in the
+   frame table, and moves the others to the free list.  Returns a
+   null pointer if every such frame is pinned or swap is full. */
+static struct frame *
+evict (enum victim_class class, struct thread *t)
+{
+  struct frame *victims[SWAP_CLUSTER_MAX];
+  size_t step, max_steps = 2 * list_size (&frame_list);
+  size_t cnt = 0;
+  struct frame *f = NULL;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  /* Two full sweeps are enough to find pages whose accessed
+     bits are clear, unless all of them are pinned.  Victims are
+     pinned while we collect them, so that the hand does not
+     pick the same one twice.  Frames outside CLASS keep their
+     accessed bits, so that a restricted sweep does not cost them
+     their second chance. */
+  for (step = 0; step < max_steps && cnt < swap_cluster; step++)
+    {
+      struct frame *v;
+
+      if (hand == list_end (&frame_list))
+        hand = list_begin (&frame_list);
+      if (hand == list_end (&frame_list))
+        break;
+      v = list_entry (hand, struct frame, elem);
+      hand = list_next (hand);
+      sweep_cnt++;
+
+      if (v->pin_cnt > 0 || !is_victim (v, class, t)
+          || test_and_clear_accessed (v))
+        continue;
+      v->pin_cnt++;
+      victims[cnt++] = v;
+    }
+  if (cnt == 0)
+    return NULL;
+
+  for (i = 0; i < cnt; i++)
+    victims[i]->pin_cnt--;
+  page_out_cluster (victims, cnt);
+  evict_pass_cnt++;
+
+  for (i = 0; i < cnt; i++)
+    {
+      struct frame *v = victims[i];
+      if (!list_empty (&v->pages))
+        continue;
+
+      evict_cnt++;
+      if (class == VICTIM_OWN)
+        own_evict_cnt++;
+      else if (class == VICTIM_OVER)
+        over_evict_cnt++;
+      uncache (v);
+      ksm_forget (v);
+      if (f == NULL)
+        f = v;
+      else
+        {
+          if (hand == &v->elem)
+            hand = list_next (hand);
+          if (scan_hand == &v->elem)
+            scan_hand = list_next (scan_hand);
+          list_remove (&v->elem);
+          list_push_back (&free_list, &v->elem);
+        }
+    }
+  return f;
+}
+
+/* Returns true if frame F belongs to CLASS: for VICTIM_OWN, if
+   all of its pages belong to T; for VICTIM_OVER, if all of them
+   belong to processes whose RSS exceeds their allotment. */
+static bool
+is_victim (struct frame *f, enum victim_class class, struct thread *t)
+{
+  struct list_elem *e;
+
+  if (class == VICTIM_ANY)
+    return true;
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      if (class == VICTIM_OWN ? p->owner != t : !p->owner->rss_over)
+        return false;
+    }
+  return true;
+}
+
+/* Sets T's allotment to ALLOT frames. */
+static void
+set_allot (struct thread *t, size_t allot)
+{
+  allot_total = allot_total - t->rss_allot + allot;
+  t->rss_allot = allot;
+  update_over (t);
+}
+
+/* Updates whether T counts as over its allotment.  A process
+   that has not taken a page fault yet has no allotment and
+   does not count. */
+static void
+update_over (struct thread *t)
+{
+  bool over = t->rss_allot > 0 && t->rss > t->rss_allot;
+  if (over != t->rss_over)
+    {
+      t->rss_over = over;
+      if (over)
+        over_cnt++;
+      else
+        over_cnt--;
+    }
+}
+
+/* Returns true if any page in frame F has been accessed since
+   the last call, and clears the accessed bits of all of them. */
+static bool
+test_and_clear_accessed (struct frame *f)
+{
+  struct list_elem *e;
+  bool accessed = false;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->owner->pagedir;
+
+      if (pagedir_is_accessed (pd, p->upage))
+        {
+          pagedir_set_accessed (pd, p->upage, false);
+          accessed = true;
+        }
+    }
+  return accessed;
+}
+
+/* Removes F from the file page cache, if it is there. */
+static void
+uncache (struct frame *f)
+{
+  if (f->cached)
+    {
+      hash_delete (&file_cache, &f->hash_elem);
+      f->cached = false;
+    }
+}
+
+/* Returns the frame in the file page cache that holds the page
+   made of READ_BYTES bytes at offset OFS in the file whose inode
+   is in SECTOR, or a null pointer if there is none.  The caller
+   must hold frame_lock. */
+static struct frame *
+find_file (block_sector_t sector, off_t ofs, uint32_t read_bytes)
+{
+  struct frame key;
+  struct hash_elem *e;
+
+  key.sector = sector;
+  key.ofs = ofs;
+  key.read_bytes = read_bytes;
+  e = hash_find (&file_cache, &key.hash_elem);
+  return e != NULL ? hash_entry (e, struct frame, hash_elem) : NULL;
+}
+
+/* Returns a hash value for the frame that E refers to. */
+static unsigned
+file_cache_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (e, struct frame, hash_elem);
+  return hash_int (f->sector) ^ hash_int (f->ofs) ^ f->read_bytes;
+}
+
+/* Returns true if the frame that A refers to precedes the one
+   that B refers to. */
+static bool
+file_cache_less (const struct hash_elem *a, const struct hash_elem *b,
+                 void *aux UNUSED)
+{
+  const struct frame *f = hash_entry (a, struct frame, hash_elem);
+  const struct frame *g = hash_entry (b, struct frame, hash_elem);
+  if (f->sector != g->sector)
+    return f->sector < g->sector;
+  else if (f->ofs != g->ofs)
+    return f->ofs < g->ofs;
+  else
+    return f->read_bytes < g->read_bytes;
+}
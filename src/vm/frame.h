@@ -0,0 +1,86 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "devices/block.h"
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+struct inode;
+struct page;
+
+/* A frame of user memory that holds a page, or that is free
+   after its page was evicted.
+
+   Several pages can share a frame copy-on-write after fork().
+   PAGES lists all of them, so that evicting the frame can unmap
+   it from every process that uses it (a "reverse map"); its
+   length is the frame's reference count.
+
+   A frame that holds a page of a file that processes share, such
+   as a page of a memory-mapped file or of a program's code, is
+   also entered in the file page cache under the file's inode
+   sector, the page's offset, and the number of bytes read from
+   the file, so that every process that maps the page finds the
+   same frame.
+
+   One frame, the zero frame, holds only zeros.  It is outside
+   the frame table, is never evicted or freed, and counts as
+   shared no matter how many pages are in it. */
+struct frame
+  {
+    struct list_elem elem;              /* Element in frame table. */
+    void *kpage;                        /* Kernel virtual address. */
+    struct list pages;                  /* Pages in this frame. */
+    unsigned pin_cnt;                   /* Not evictable if nonzero. */
+    struct list_elem write_elem;        /* Element in write-back queue. */
+
+    /* File page cache. */
+    bool cached;                        /* In the file page cache? */
+    block_sector_t sector;              /* Inode sector of file. */
+    off_t ofs;                          /* Offset of page in file. */
+    uint32_t read_bytes;                /* Bytes of page read from file. */
+    struct hash_elem hash_elem;         /* Element in file page cache. */
+
+    /* Same-page merging (see vm/ksm.c). */
+    unsigned ksm_sum;                   /* Checksum at last visit. */
+    bool ksm_checked;                   /* KSM_SUM valid? */
+    bool ksm_stable;                    /* In table of stable frames? */
+    bool ksm_merged;                    /* Has absorbed other frames? */
+    struct hash_elem ksm_elem;          /* Element in stable frames. */
+  };
+
+/* Protects the frame table, the PAGES and PIN_CNT members of
+   every frame, the file page cache, and the FRAME and SWAP_SLOT
+   members of every struct page that has a frame. */
+extern struct lock frame_lock;
+
+extern size_t rss_max_pages;
+
+void frame_init (void);
+struct frame *frame_alloc (void);
+struct frame *frame_try_alloc (void);
+void frame_pin (struct frame *);
+void frame_unpin (struct frame *);
+void frame_add_page (struct frame *, struct page *);
+void frame_remove_page (struct frame *, struct page *);
+void frame_deactivate (struct frame *);
+bool frame_is_shared (struct frame *);
+void frame_fault (void);
+void frame_release_allot (void);
+struct frame *frame_zero (void);
+size_t frame_zero_cnt (void);
+struct frame *frame_lookup_file (struct inode *, off_t ofs,
+                                 uint32_t read_bytes);
+struct frame *frame_insert_file (struct frame *, struct inode *, off_t ofs,
+                                 uint32_t read_bytes);
+void frame_write_file (struct inode *, off_t ofs, const void *, off_t size);
+struct frame *frame_scan_next (void);
+void frame_free (struct frame *);
+void frame_free_if_unused (struct frame *);
+void frame_print_stats (void);
+
+#endif /* vm/frame.h */
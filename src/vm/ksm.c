@@ -0,0 +1,232 @@
+#include "vm/ksm.h"
+#include <debug.h>
+#include <hash.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+
+/* Same-page merging.
+
+   Processes often hold identical pages that the kernel cannot
+   know to share in advance, such as lookup tables that each
+   process builds the same way.  A low-priority kernel thread
+   therefore walks the frame table, a few frames per pass, and
+   merges frames with identical contents into one frame that all
+   of their pages share copy-on-write, exactly like a frame that
+   fork() shares.  A later write to one of the pages faults and
+   page_copy_on_write() gives the writer a private copy again.
+
+   The thread keeps a checksum of each frame it visits.  A frame
+   whose checksum is the same on two visits in a row is "stable"
+   and goes into a hash table keyed by checksum; frames that
+   change between visits are not worth merging, because they
+   would be split again right away.  A stable frame whose
+   checksum matches a frame already in the table is compared
+   byte for byte, after both are write-protected so that their
+   contents cannot change under us, and merged into it if they
+   are equal.  A stable frame of all zeros is merged into the
+   zero frame.
+
+   Frames of memory-mapped files and shared executable pages are
+   left alone: they are shared through the file page cache
+   already, and writes to mapped pages do not copy on write.
+
+   The table is protected by frame_lock, and frames leave it
+   through ksm_forget() when they are evicted or freed. */
+
+/* Frames to visit per pass, and milliseconds to sleep between
+   passes.  0 frames per pass, the default, disables merging, so
+   that it does not change the faults and timing of processes
+   that do not ask for it.
+   Controlled by kernel command-line options "-ksm" and
+   "-ksm-sleep". */
+size_t ksm_pages_per_pass = 0;
+unsigned ksm_sleep_ms = 50;
+
+/* Stable frames, keyed by checksum. */
+static struct hash stable_frames;
+
+/* Checksum of a page of zeros. */
+static unsigned zero_sum;
+
+/* Statistics. */
+static long long pass_cnt;              /* Passes made. */
+static long long scan_cnt;              /* Frames visited. */
+static long long merge_cnt;             /* Frames merged away. */
+static long long zero_merge_cnt;        /* ...into the zero frame. */
+static long long shared_cnt;            /* Frames that absorbed others. */
+static long long mismatch_cnt;          /* Checksums equal, data not. */
+
+static thread_func ksm_thread NO_RETURN;
+static bool scan_frame (void);
+static bool is_mergeable (struct frame *);
+static hash_hash_func stable_hash;
+static hash_less_func stable_less;
+
+/* Starts the merging thread, unless merging is disabled.  Must
+   be called after frame_init(). */
+void
+ksm_init (void)
+{
+  static const uint8_t zeros[PGSIZE];
+
+  if (!hash_init (&stable_frames, stable_hash, stable_less, NULL))
+    PANIC ("ksm: out of memory");
+  zero_sum = hash_bytes (zeros, PGSIZE);
+  if (ksm_pages_per_pass > 0)
+    thread_create ("ksm", PRI_MIN, ksm_thread, NULL);
+}
+
+/* Removes F from the table of stable frames, if it is there.
+   Called when F's contents are about to change or F is about to
+   be freed.  The caller must hold frame_lock. */
+void
+ksm_forget (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (f->ksm_stable)
+    {
+      hash_delete (&stable_frames, &f->ksm_elem);
+      f->ksm_stable = false;
+    }
+}
+
+/* Prints merging statistics. */
+void
+ksm_print_stats (void)
+{
+  printf ("KSM: %lld frames scanned in %lld passes, %lld merged away "
+          "(%lld into the zero frame), %lld frames shared, "
+          "%lld checksum collisions\n",
+          scan_cnt, pass_cnt, merge_cnt, zero_merge_cnt, shared_cnt,
+          mismatch_cnt);
+}
+
+/* Merging thread.  Visits ksm_pages_per_pass frames, then sleeps
+   for ksm_sleep_ms milliseconds, forever. */
+static void
+ksm_thread (void *aux UNUSED)
+{
+  for (;;)
+    {
+      size_t i;
+
+      timer_msleep (ksm_sleep_ms);
+      for (i = 0; i < ksm_pages_per_pass; i++)
+        if (!scan_frame ())
+          break;
+      pass_cnt++;
+    }
+}
+
+/* Visits the next frame in the frame table and merges it with
+   another if possible.  Returns false if the frame table is
+   empty. */
+static bool
+scan_frame (void)
+{
+  struct frame *f, *other;
+  unsigned sum;
+
+  lock_acquire (&frame_lock);
+  f = frame_scan_next ();
+  if (f == NULL)
+    {
+      lock_release (&frame_lock);
+      return false;
+    }
+  scan_cnt++;
+  if (!is_mergeable (f))
+    goto done;
+
+  /* Skip F until its contents are the same on two visits. */
+  sum = hash_bytes (f->kpage, PGSIZE);
+  if (!f->ksm_checked || sum != f->ksm_sum)
+    {
+      ksm_forget (f);
+      f->ksm_sum = sum;
+      f->ksm_checked = true;
+      goto done;
+    }
+
+  /* Find a frame with the same contents. */
+  if (sum == zero_sum)
+    other = frame_zero ();
+  else if (f->ksm_stable)
+    goto done;
+  else
+    {
+      struct hash_elem *e = hash_insert (&stable_frames, &f->ksm_elem);
+      if (e == NULL)
+        {
+          f->ksm_stable = true;
+          goto done;
+        }
+      other = hash_entry (e, struct frame, ksm_elem);
+      if (!is_mergeable (other))
+        goto done;
+    }
+
+  /* Merge F into OTHER, if they really are the same. */
+  if (!page_merge (f, other))
+    {
+      mismatch_cnt++;
+      goto done;
+    }
+  if (other == frame_zero ())
+    zero_merge_cnt++;
+  else if (!other->ksm_merged)
+    {
+      other->ksm_merged = true;
+      shared_cnt++;
+    }
+  merge_cnt++;
+  frame_free (f);
+
+ done:
+  lock_release (&frame_lock);
+  return true;
+}
+
+/* Returns true if F holds only ordinary anonymous or private
+   pages, none of which is being read in or out, so that it may
+   be merged with another frame. */
+static bool
+is_mergeable (struct frame *f)
+{
+  struct list_elem *e;
+
+  if (f->pin_cnt > 0 || f->cached || list_empty (&f->pages))
+    return false;
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      if (p->mapped || p->read_ahead)
+        return false;
+    }
+  return true;
+}
+
+/* Returns a hash value for the frame that E refers to. */
+static unsigned
+stable_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_entry (e, struct frame, ksm_elem)->ksm_sum;
+}
+
+/* Returns true if the frame that A refers to precedes the one
+   that B refers to. */
+static bool
+stable_less (const struct hash_elem *a, const struct hash_elem *b,
+             void *aux UNUSED)
+{
+  return (hash_entry (a, struct frame, ksm_elem)->ksm_sum
+          < hash_entry (b, struct frame, ksm_elem)->ksm_sum);
+}
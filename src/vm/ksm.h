@@ -0,0 +1,15 @@
+#ifndef VM_KSM_H
+#define VM_KSM_H
+
+#include <stddef.h>
+
+struct frame;
+
+extern size_t ksm_pages_per_pass;
+extern unsigned ksm_sleep_ms;
+
+void ksm_init (void);
+void ksm_forget (struct frame *);
+void ksm_print_stats (void);
+
+#endif /* vm/ksm.h */
@@ -0,0 +1,169 @@
+#include "vm/lz.h"
+#include <debug.h>
+#include <string.h>
+
+/* A fast, simple LZ77 compressor in the style of LZRW1.
+
+   The output is a series of groups.  Each group is a 16-bit
+   little-endian control word followed by up to 16 items, one per
+   bit of the control word, starting from the least significant
+   bit.  A 0 bit denotes a literal item, a single byte that is
+   copied to the output.  A 1 bit denotes a copy item, two bytes
+   that give a length L from 3 to 18 and an offset O from 1 to
+   LZ_MAX_OFFSET, meaning "copy L bytes starting O bytes back in
+   the output".  The length minus 3 is in the high 4 bits of the
+   first byte; the offset is in the low 4 bits of the first byte
+   (high part) and in the second byte (low part).
+
+   Matches are found with a hash table indexed by the next three
+   bytes of input, which remembers only the most recent position
+   with each hash.  That finds fewer matches than a real search
+   would, but it is very fast, and the pages that we compress
+   (mostly zeros, small integers, and repeated structures) give
+   it plenty to find. */
+
+#define MIN_MATCH 3
+#define MAX_MATCH (MIN_MATCH + 15)
+
+/* Returns the hash table index for the three bytes at P. */
+static inline size_t
+hash3 (const uint8_t *p)
+{
+  uint32_t x = ((uint32_t) p[0] << 16) | ((uint32_t) p[1] << 8) | p[2];
+  return ((x * 40543) >> 4) % LZ_HASH_SIZE;
+}
+
+/* Compresses the SRC_SIZE bytes at SRC into DST, which has room
+   for DST_SIZE bytes, using TABLE as scratch space.  SRC_SIZE
+   must be at most 65535.  Returns the size of the compressed
+   data, or 0 if it would not fit in DST_SIZE bytes. */
+size_t
+lz_compress (const void *src_, size_t src_size, void *dst_, size_t dst_size,
+             uint16_t table[LZ_HASH_SIZE])
+{
+  const uint8_t *src = src_;
+  const uint8_t *p = src;
+  const uint8_t *end = src + src_size;
+  uint8_t *dst = dst_;
+  uint8_t *out = dst;
+  uint8_t *out_end = dst + dst_size;
+  uint8_t *ctrl_ptr = NULL;
+  unsigned ctrl = 0;
+  int ctrl_bits = 16;
+
+  ASSERT (src_size <= 65535);
+
+  memset (table, 0, LZ_HASH_SIZE * sizeof *table);
+  while (p < end)
+    {
+      const uint8_t *q;
+      size_t h, ofs, len;
+
+      /* Start a new group if the current one is full. */
+      if (ctrl_bits == 16)
+        {
+          if (ctrl_ptr != NULL)
+            {
+              ctrl_ptr[0] = ctrl & 0xff;
+              ctrl_ptr[1] = ctrl >> 8;
+            }
+          if (out_end - out < 2)
+            return 0;
+          ctrl_ptr = out;
+          out += 2;
+          ctrl = 0;
+          ctrl_bits = 0;
+        }
+
+      /* Look for a match at the last position with the same
+         hash, but only if there are enough bytes left to make
+         one worthwhile. */
+      len = 0;
+      if (end - p > MAX_MATCH)
+        {
+          h = hash3 (p);
+          q = src + table[h];
+          table[h] = p - src;
+          ofs = p - q;
+          if (ofs > 0 && ofs <= LZ_MAX_OFFSET
+              && q[0] == p[0] && q[1] == p[1] && q[2] == p[2])
+            for (len = MIN_MATCH; len < MAX_MATCH && q[len] == p[len]; len++)
+              continue;
+        }
+
+      if (len > 0)
+        {
+          if (out_end - out < 2)
+            return 0;
+          *out++ = ((len - MIN_MATCH) << 4) | (ofs >> 8);
+          *out++ = ofs & 0xff;
+          ctrl |= 1u << ctrl_bits;
+          p += len;
+        }
+      else
+        {
+          if (out_end - out < 1)
+            return 0;
+          *out++ = *p++;
+        }
+      ctrl_bits++;
+    }
+  if (ctrl_ptr != NULL)
+    {
+      ctrl_ptr[0] = ctrl & 0xff;
+      ctrl_ptr[1] = ctrl >> 8;
+    }
+  return out - dst;
+}
+
+/* Decompresses the SRC_SIZE bytes of compressed data at SRC into
+   DST, which has room for DST_SIZE bytes.  Returns the size of
+   the decompressed data, or 0 if SRC is not valid compressed data
+   or would not fit. */
+size_t
+lz_decompress (const void *src_, size_t src_size, void *dst_, size_t dst_size)
+{
+  const uint8_t *in = src_;
+  const uint8_t *in_end = in + src_size;
+  uint8_t *dst = dst_;
+  uint8_t *out = dst;
+  uint8_t *out_end = dst + dst_size;
+
+  while (in < in_end)
+    {
+      unsigned ctrl;
+      int bit;
+
+      if (in_end - in < 2)
+        return 0;
+      ctrl = in[0] | (in[1] << 8);
+      in += 2;
+
+      for (bit = 0; bit < 16 && in < in_end; bit++, ctrl >>= 1)
+        if (ctrl & 1)
+          {
+            size_t len, ofs;
+
+            if (in_end - in < 2)
+              return 0;
+            len = (in[0] >> 4) + MIN_MATCH;
+            ofs = ((in[0] & 0x0f) << 8) | in[1];
+            in += 2;
+            if (ofs == 0 || ofs > (size_t) (out - dst)
+                || len > (size_t) (out_end - out))
+              return 0;
+
+            /* Byte by byte, since the source and destination
+               overlap when OFS < LEN. */
+            for (; len > 0; len--, out++)
+              *out = out[-ofs];
+          }
+        else
+          {
+            if (out == out_end)
+              return 0;
+            *out++ = *in++;
+          }
+    }
+  return out - dst;
+}
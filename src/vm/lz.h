@@ -0,0 +1,19 @@
+#ifndef VM_LZ_H
+#define VM_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Number of entries in the hash table that lz_compress() uses. */
+#define LZ_HASH_SIZE 4096
+
+/* Largest offset that a match can refer back to. */
+#define LZ_MAX_OFFSET 4095
+
+size_t lz_compress (const void *src, size_t src_size,
+                    void *dst, size_t dst_size,
+                    uint16_t table[LZ_HASH_SIZE]);
+size_t lz_decompress (const void *src, size_t src_size,
+                      void *dst, size_t dst_size);
+
+#endif /* vm/lz.h */
@@ -0,0 +1,156 @@
+#include "vm/mmap.h"
+#include <list.h>
+#include <round.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/page.h"
+
+/* Memory-mapped files.
+
+   mmap_map() maps a file into consecutive pages of the current
+   process's address space.  Nothing is read at that point: each
+   page is recorded in the supplemental page table, and the first
+   access to it faults it in from the file.  Processes that map
+   the same file share the frames that hold it, so that they see
+   each other's writes right away, and modified pages are written
+   back to the file only when they are evicted or unmapped. */
+
+/* A file mapped into a process's address space. */
+struct mapping
+  {
+    struct list_elem elem;              /* Element in thread's list. */
+    mapid_t id;                         /* Mapping identifier. */
+    struct file *file;                  /* File, reopened for mapping. */
+    uint8_t *base;                      /* First mapped page. */
+    size_t page_cnt;                    /* Number of mapped pages. */
+  };
+
+static struct mapping *find_mapping (mapid_t);
+static void unmap (struct mapping *);
+
+/* Maps FILE into the current process's address space starting at
+   page-aligned user address ADDR, and returns the new mapping's
+   identifier.  The mapping remains valid after FILE is closed.
+   Returns MAP_FAILED if ADDR is null or not page-aligned, if
+   FILE is empty, if the pages it would occupy overlap any that
+   are already in use, or if memory allocation fails. */
+mapid_t
+mmap_map (struct file *file, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  off_t length;
+  size_t i;
+
+  if (file == NULL || addr == NULL || pg_ofs (addr) != 0
+      || !is_user_vaddr (addr))
+    return MAP_FAILED;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return MAP_FAILED;
+  m->file = file_reopen (file);
+  if (m->file == NULL)
+    goto fail;
+  length = file_length (m->file);
+  m->base = addr;
+  m->page_cnt = DIV_ROUND_UP (length, PGSIZE);
+  if (length == 0
+      || m->page_cnt > (size_t) ((uint8_t *) PHYS_BASE - m->base) / PGSIZE)
+    goto fail;
+
+  /* The range must be unused.  An I/O ring (see userprog/ioring.c)
+     is mapped without a supplemental page table entry, so check
+     the page directory as well. */
+  for (i = 0; i < m->page_cnt; i++)
+    if (page_lookup (t->pages, m->base + i * PGSIZE) != NULL
+        || pagedir_get_page (t->pagedir, m->base + i * PGSIZE) != NULL)
+      goto fail;
+
+  for (i = 0; i < m->page_cnt; i++)
+    {
+      off_t ofs = i * PGSIZE;
+      uint32_t read_bytes = length - ofs < PGSIZE ? length - ofs : PGSIZE;
+
+      if (!page_add_mmap (t->pages, m->base + ofs, m->file, ofs, read_bytes))
+        {
+          while (i-- > 0)
+            page_remove (t->pages, m->base + i * PGSIZE);
+          goto fail;
+        }
+    }
+
+  m->id = t->next_mapid++;
+  list_push_back (&t->mappings, &m->elem);
+  return m->id;
+
+ fail:
+  file_close (m->file);
+  free (m);
+  return MAP_FAILED;
+}
+
+/* Unmaps mapping MAPID of the current process, writing back any
+   pages that were modified.  Returns true if successful, false
+   if the process has no such mapping. */
+bool
+mmap_unmap (mapid_t mapid)
+{
+  struct mapping *m = find_mapping (mapid);
+
+  if (m == NULL)
+    return false;
+  unmap (m);
+  return true;
+}
+
+/* Unmaps all of the current process's mappings. */
+void
+mmap_unmap_all (void)
+{
+  struct thread *t = thread_current ();
+
+  while (!list_empty (&t->mappings))
+    unmap (list_entry (list_front (&t->mappings), struct mapping, elem));
+}
+
+/* Returns the current process's mapping with identifier MAPID,
+   or a null pointer if there is none. */
+static struct mapping *
+find_mapping (mapid_t mapid)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->mappings); e != list_end (&t->mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->id == mapid)
+        return m;
+    }
+  return NULL;
+}
+
+/* Removes M's pages from the current process, writing back the
+   modified ones, and frees M.  Holds filesys_lock throughout,
+   so that a frame that is being written back by another thread
+   keeps its pages and their file (see vm/page.c). */
+static void
+unmap (struct mapping *m)
+{
+  struct thread *t = thread_current ();
+  size_t i;
+
+  lock_acquire (&filesys_lock);
+  for (i = 0; i < m->page_cnt; i++)
+    page_remove (t->pages, m->base + i * PGSIZE);
+  file_close (m->file);
+  lock_release (&filesys_lock);
+  list_remove (&m->elem);
+  free (m);
+}
@@ -0,0 +1,1401 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/* Supplemental page table.
+
+   When a process is loaded, load_segment() records each page of
+   each segment here instead of reading it into memory.  The
+   first access to a page faults, and page_fault() calls
+   page_in() to allocate a frame, fill it from the executable
+   (or with zeros), and map it.  Pages that are never touched
+   are never read, so exec is fast and resident memory stays
+   small even for large programs.
+
+   When memory runs short, the frame table evicts pages with
+   page_out_cluster().  A page that was modified goes to swap and
+   comes back from there on its next fault; a clean page is
+   simply dropped and read again from its original source.
+
+   Evicted pages of a process that are adjacent in virtual memory
+   tend to be written to adjacent swap slots.  So, when a page is
+   read from swap, the pages that follow it in both virtual
+   memory and swap are read too, as long as free frames are
+   available ("read-around").  Those pages are left unmapped and
+   keep their swap slots: if the process touches one, a cheap
+   fault maps it; if it is evicted first, it is simply dropped.
+
+   fork() copies the parent's page table with page_table_copy().
+   The child's pages share the parent's frames and swap slots,
+   and every shared frame is mapped read-only in both processes.
+   Writing to one faults, and page_copy_on_write() gives the
+   writer a private copy of the page, or, if it is the last page
+   left in the frame, simply makes the frame writable again.  A
+   shared page in swap is copied when it is read back in, since
+   each process then gets a frame of its own.
+
+   Pages of memory-mapped files (see vm/mmap.c) are different:
+   all the processes that map a page of a file share one frame,
+   found through the frame table's file page cache, and may all
+   write to it.  Such a page is never written to swap.  If it is
+   dirty when it is evicted or unmapped, it is written back to
+   its file instead.  fork() does not copy mappings.
+
+   Reading a page from its file and writing a mapped page back
+   go through the file system, so they happen under filesys_lock,
+   like system calls, and never with frame_lock held, since a
+   system call that holds filesys_lock may fault and need
+   frame_lock.  A fault taken by a system call already holds
+   filesys_lock and just keeps it.  Eviction cannot give up
+   frame_lock in the middle of choosing victims, so
+   page_out_cluster() leaves a modified mapped frame mapped,
+   pinned, and queued, and frame_alloc() writes it back with
+   page_write_back() once it has released frame_lock; the frame
+   is clean the next time the clock comes around.  Pages of
+   memory-mapped files are removed only under filesys_lock, so
+   the files of the queued frames' pages stay open while they are
+   written.  A shared page read from its file enters the file
+   page cache before filesys_lock is released, so that
+   frame_write_file() sees every write to the file that follows.
+
+   A process's stack starts out as a single page.  A fault just
+   below the stack pointer (or up to 32 bytes below, which the
+   PUSHA instruction can touch) grows it, up to stack_max_pages
+   pages, with page_grow_stack().  When the stack keeps growing
+   one page at a time, as in deep recursion, each such fault maps
+   more pages ahead of the stack pointer, doubling the number
+   each time up to STACK_AHEAD_MAX, so that a deep stack costs a
+   few faults rather than one per page.
+
+   Pages that start out all zeros, such as BSS and the stack, are
+   mapped read-only to a single zero frame when they are first
+   read.  Only a write gives such a page a frame of its own,
+   through the same path as copy-on-write.  A program that reads
+   parts of a large zeroed array thus costs no memory for them.
+
+   Read-only pages of executables, that is, code and constant
+   data, are shared through the file page cache in the same way.
+   N processes running the same program thus keep one copy of
+   its code in memory, plus N copies of its data.  The frames are
+   freed when the last process that uses them exits (or when they
+   are evicted, which costs nothing, since they are clean).
+
+   A process can describe how it will use a range of its pages
+   with page_advise() (the madvise system call).  Faults on pages
+   marked PAGE_SEQUENTIAL read the next SEQ_AHEAD pages ahead of
+   time, from their files as well as from swap, and move the page
+   SEQ_BEHIND pages back to the front of the clock, since the
+   process has most likely finished with it.  Faults on pages
+   marked PAGE_RANDOM do no read-around at all.  PAGE_WILLNEED
+   reads pages in at once, as far as free frames allow, and
+   PAGE_DONTNEED throws pages away, so that their next access
+   starts over from their initial contents.
+
+   The same-page merging thread (see vm/ksm.c) finds frames with
+   identical contents and moves all of their pages into one of
+   them with page_merge(), after which they are shared
+   copy-on-write as if by fork(). */
+
+/* Maximum size of a user stack, in pages.
+   Controlled by kernel command-line option "-stack". */
+size_t stack_max_pages = 2048;
+
+/* Maximum number of stack pages to map ahead of a fault. */
+#define STACK_AHEAD_MAX 32
+
+/* For pages marked PAGE_SEQUENTIAL: number of pages to read ahead
+   of a fault, and distance behind a fault of the page to evict
+   early. */
+#define SEQ_AHEAD 16
+#define SEQ_BEHIND 16
+
+/* Statistics. */
+static long long page_in_cnt;           /* Pages brought in. */
+static long long page_in_file_cnt;      /* ...of which read from a file. */
+static long long page_in_swap_cnt;      /* ...of which read from swap. */
+static long long page_drop_cnt;         /* Clean pages dropped. */
+static long long read_ahead_cnt;        /* Pages read around a fault. */
+static long long read_ahead_hit_cnt;    /* ...later used. */
+static long long read_ahead_miss_cnt;   /* ...dropped unused. */
+static long long cow_copy_cnt;          /* Pages copied on write. */
+static long long cow_reuse_cnt;         /* ...made writable in place. */
+static long long fork_share_cnt;        /* Frames shared by fork. */
+static long long file_share_cnt;        /* Shared file pages found. */
+static long long write_back_cnt;        /* Mapped pages written back. */
+static long long zero_map_cnt;          /* Reads mapped to zero frame. */
+static long long zero_copy_cnt;         /* ...later written. */
+static long long stack_grow_cnt;        /* Stack growth faults. */
+static long long stack_ahead_cnt;       /* Stack pages mapped ahead. */
+static long long prefetch_cnt;          /* Pages read on advice. */
+static long long deactivate_cnt;        /* Pages behind sequential faults. */
+static long long discard_cnt;           /* Pages discarded on advice. */
+
+/* Frames that hold modified pages of memory-mapped files, set
+   aside by page_out_cluster() for page_write_back(), pinned.
+   Protected by frame_lock. */
+static struct list write_back_queue = LIST_INITIALIZER (write_back_queue);
+
+static bool fault_in (struct page *, bool write, enum fault_class *);
+static bool load_page (struct page *, void *kpage);
+static void read_around (struct page *, size_t slot);
+static void sequential_fault (struct page *);
+static bool prefetch_page (struct page *);
+static void discard_page (struct page *);
+static struct page *add_page (struct hash *, void *upage, struct file *,
+                               off_t ofs, uint32_t read_bytes, bool writable);
+static bool shares_file (const struct page *);
+static bool map_writable (struct page *);
+static bool map_page (struct page *);
+static bool lock_filesys (void);
+static void flush_page (struct page *);
+static struct page *clean_frame (struct frame *);
+static void remap_frame (struct frame *);
+static void write_back (struct page *, struct frame *);
+static void evict_frame (struct frame *, size_t slot);
+static void release_page (struct page *);
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destroy;
+
+/* Creates and returns a new, empty supplemental page table, or
+   a null pointer if memory allocation fails. */
+struct hash *
+page_table_create (void)
+{
+  struct hash *pages = malloc (sizeof *pages);
+  if (pages != NULL && !hash_init (pages, page_hash, page_less, NULL))
+    {
+      free (pages);
+      pages = NULL;
+    }
+  return pages;
+}
+
+/* Creates and returns a copy of supplemental page table SRC,
+   which belongs to another process, for the current process.
+   Pages with a frame are mapped, read-only, into the same frame
+   in both processes; pages in swap share the swap slot.  Pages
+   of memory-mapped files are not copied.  Pages
+   backed by OLD_FILE are backed by NEW_FILE in the copy.  The
+   owner of SRC must not run until this function returns.
+   Returns a null pointer if memory allocation fails. */
+struct hash *
+page_table_copy (struct hash *src, struct file *old_file,
+                 struct file *new_file)
+{
+  struct thread *t = thread_current ();
+  struct hash *pages = page_table_create ();
+  struct hash_iterator i;
+  bool success = true;
+
+  if (pages == NULL)
+    return NULL;
+
+  lock_acquire (&frame_lock);
+  hash_first (&i, src);
+  while (success && hash_next (&i))
+    {
+      struct page *p = hash_entry (hash_cur (&i), struct page, hash_elem);
+      struct page *c;
+
+      if (p->mapped)
+        continue;
+      c = malloc (sizeof *c);
+      if (c == NULL)
+        {
+          success = false;
+          break;
+        }
+
+      *c = *p;
+      c->owner = t;
+      c->frame = NULL;
+      c->read_ahead = false;
+      if (c->file == old_file)
+        c->file = new_file;
+      hash_insert (pages, &c->hash_elem);
+
+      if (p->frame != NULL && !p->read_ahead)
+        {
+          /* Share P's frame.  C inherits P's dirty bit, so that
+             whichever of them keeps the frame writes it to swap
+             if it differs from its initial contents. */
+          uint32_t *pd = p->owner->pagedir;
+          if (!pagedir_set_page (t->pagedir, c->upage, p->frame->kpage,
+                                 false))
+            success = false;
+          else
+            {
+              pagedir_set_dirty (t->pagedir, c->upage,
+                                 pagedir_is_dirty (pd, p->upage));
+              pagedir_protect_range (pd, p->upage, 1, false);
+              frame_add_page (p->frame, c);
+              fork_share_cnt++;
+            }
+        }
+      if (c->swap_slot != SWAP_NONE)
+        swap_dup (c->swap_slot);
+    }
+  lock_release (&frame_lock);
+
+  if (!success)
+    {
+      page_table_destroy (pages);
+      pages = NULL;
+    }
+  return pages;
+}
+
+/* Destroys supplemental page table PAGES, which must belong to
+   the current thread, unmapping its pages and freeing their
+   frames and swap slots, and gives up the thread's frame
+   allotment.  PAGES must not contain pages of memory-mapped
+   files any more; see mmap_unmap_all(). */
+void
+page_table_destroy (struct hash *pages)
+{
+  if (pages == NULL)
+    return;
+
+  lock_acquire (&frame_lock);
+  hash_destroy (pages, page_destroy);
+  frame_release_allot ();
+  lock_release (&frame_lock);
+  free (pages);
+}
+
+/* Adds user virtual page UPAGE to PAGES.  When first accessed,
+   the page will be filled with READ_BYTES bytes read from FILE
+   starting at offset OFS, followed by PGSIZE - READ_BYTES zeros.
+   If READ_BYTES is 0 then FILE is not used and may be null.
+   The page will be writable by the user process if WRITABLE is
+   true, read-only otherwise.  PAGES must belong to the current
+   thread.
+   FILE must remain open as long as the page table exists.
+   Returns true if successful, false if UPAGE is already in
+   PAGES or if memory allocation fails. */
+bool
+page_add_file (struct hash *pages, void *upage, struct file *file,
+               off_t ofs, uint32_t read_bytes, bool writable)
+{
+  return add_page (pages, upage, file, ofs, read_bytes, writable) != NULL;
+}
+
+/* Adds user virtual page UPAGE to PAGES as a writable page of a
+   memory-mapped file.  It holds READ_BYTES bytes, which must be
+   nonzero, at offset OFS in FILE, followed by zeros.  Processes
+   that map the same page of a file share it, and changes to it
+   are written back to FILE.  PAGES must belong to the current
+   thread, and FILE must remain open as long as the page exists.
+   Returns true if successful, false if UPAGE is already in
+   PAGES or if memory allocation fails. */
+bool
+page_add_mmap (struct hash *pages, void *upage, struct file *file,
+               off_t ofs, uint32_t read_bytes)
+{
+  struct page *p;
+
+  ASSERT (read_bytes > 0);
+
+  p = add_page (pages, upage, file, ofs, read_bytes, true);
+  if (p == NULL)
+    return false;
+  p->mapped = true;
+  return true;
+}
+
+/* Removes the page that contains UADDR from PAGES, which must
+   belong to the current thread.  If it is a page of a
+   memory-mapped file that was modified, writes it back first.
+   The caller must not hold frame_lock. */
+void
+page_remove (struct hash *pages, const void *uaddr)
+{
+  struct page *p = page_lookup (pages, uaddr);
+  bool locked;
+
+  if (p == NULL)
+    return;
+
+  locked = p->mapped && lock_filesys ();
+  flush_page (p);
+  lock_acquire (&frame_lock);
+  hash_delete (pages, &p->hash_elem);
+  release_page (p);
+  lock_release (&frame_lock);
+  if (locked)
+    lock_release (&filesys_lock);
+  free (p);
+}
+
+/* Returns the page in PAGES that contains user virtual address
+   UADDR, or a null pointer if there is none. */
+struct page *
+page_lookup (struct hash *pages, const void *uaddr)
+{
+  struct page p;
+  struct hash_elem *e;
+
+  p.upage = pg_round_down (uaddr);
+  e = hash_find (pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Brings the page that contains FAULT_ADDR into memory for the
+   current process and maps it.  WRITE should be true if the
+   fault was caused by a write, false if by a read.  If CLASS is
+   nonnull, stores into *CLASS how the page was brought in, for
+   statistics.  Returns true if successful,
+   false if FAULT_ADDR is not part of the process's address
+   space or if it cannot be loaded, in which case the fault is a
+   genuine error. */
+bool
+page_in (void *fault_addr, bool write, enum fault_class *class)
+{
+  struct thread *t = thread_current ();
+  enum fault_class dummy;
+  struct page *p;
+
+  if (t->pages == NULL || !is_user_vaddr (fault_addr))
+    return false;
+
+  p = page_lookup (t->pages, fault_addr);
+  if (p == NULL || !fault_in (p, write, class != NULL ? class : &dummy))
+    return false;
+
+  if (p->advice == PAGE_SEQUENTIAL)
+    sequential_fault (p);
+  return true;
+}
+
+/* Applies ADVICE, one of the PAGE_* hints, to the LENGTH bytes
+   of the current process's address space starting at ADDR, which
+   must be page-aligned.  Returns true if successful, false if
+   the arguments are invalid or if part of the range is not in
+   the address space, in which case the advice is still applied
+   to the pages that are. */
+bool
+page_advise (void *addr, size_t length, int advice)
+{
+  struct thread *t = thread_current ();
+  uint8_t *upage = addr;
+  uint8_t *end;
+  bool frames_left = true;
+  bool success = true;
+
+  if (t->pages == NULL || pg_ofs (addr) != 0 || !is_user_vaddr (addr)
+      || length > (size_t) ((uint8_t *) PHYS_BASE - upage)
+      || advice < PAGE_NORMAL || advice > PAGE_DONTNEED)
+    return false;
+
+  end = upage + ROUND_UP (length, PGSIZE);
+  for (; upage < end; upage += PGSIZE)
+    {
+      struct page *p = page_lookup (t->pages, upage);
+      if (p == NULL)
+        {
+          success = false;
+          continue;
+        }
+
+      /* Once free frames run out, there is no point in
+         prefetching further pages. */
+      if (advice == PAGE_WILLNEED)
+        frames_left = frames_left && prefetch_page (p);
+      else if (advice == PAGE_DONTNEED)
+        discard_page (p);
+      else
+        p->advice = advice;
+    }
+  return success;
+}
+
+/* Brings page P of the current process into memory and maps it,
+   as described for page_in(), and stores how into *CLASS. */
+static bool
+fault_in (struct page *p, bool write, enum fault_class *class)
+{
+  struct frame *f;
+  uint8_t *kpage;
+  size_t slot;
+  bool locked = false;
+
+  /* If P was read ahead, just map it. */
+  lock_acquire (&frame_lock);
+  frame_fault ();
+  if (p->frame != NULL)
+    {
+      bool success = p->read_ahead && map_page (p);
+      if (success)
+        {
+          p->read_ahead = false;
+          read_ahead_hit_cnt++;
+          *class = FAULT_MINOR;
+        }
+      lock_release (&frame_lock);
+      return success;
+    }
+
+  /* Use a frame that is already in memory, if P can share one:
+     another process's copy of P's page of a shared file or, for
+     a read of a page that has never held anything but zeros,
+     the zero frame.  A write to the zero frame faults again and
+     gets a private copy. */
+  f = NULL;
+  if (shares_file (p))
+    f = frame_lookup_file (file_get_inode (p->file), p->file_ofs,
+                           p->read_bytes);
+  else if (!write && p->file == NULL && p->swap_slot == SWAP_NONE)
+    f = frame_zero ();
+  if (f != NULL)
+    {
+      bool success;
+
+      frame_add_page (f, p);
+      success = map_page (p);
+      if (!success)
+        frame_remove_page (f, p);
+      else if (f == frame_zero ())
+        {
+          zero_map_cnt++;
+          *class = FAULT_ZERO;
+        }
+      else
+        {
+          file_share_cnt++;
+          *class = FAULT_MINOR;
+        }
+      lock_release (&frame_lock);
+      return success;
+    }
+  lock_release (&frame_lock);
+
+  /* Getting a frame waits for any eviction of P in progress to
+     finish.  Afterward, only this thread can change P. */
+  f = frame_alloc ();
+  if (f == NULL)
+    return false;
+  if (p->frame != NULL)
+    goto fail;
+  kpage = f->kpage;
+
+  /* Keep filesys_lock until a page read from a shared file is in
+     the file page cache, where writes to the file find it. */
+  slot = p->swap_slot;
+  locked = slot == SWAP_NONE && p->file != NULL && lock_filesys ();
+  if (!load_page (p, kpage))
+    goto fail;
+
+  lock_acquire (&frame_lock);
+  if (shares_file (p))
+    {
+      /* Another process may have read the same page meanwhile.
+         If so, use its frame and discard ours. */
+      struct frame *other = frame_insert_file (f, file_get_inode (p->file),
+                                               p->file_ofs, p->read_bytes);
+      if (other != NULL)
+        {
+          frame_unpin (f);
+          frame_free (f);
+          f = other;
+          frame_pin (f);
+        }
+    }
+  frame_add_page (f, p);
+  if (!map_page (p))
+    {
+      frame_remove_page (f, p);
+      lock_release (&frame_lock);
+      goto fail;
+    }
+  frame_unpin (f);
+  lock_release (&frame_lock);
+  if (locked)
+    lock_release (&filesys_lock);
+
+  page_in_cnt++;
+  if (slot != SWAP_NONE)
+    {
+      page_in_swap_cnt++;
+      *class = FAULT_SWAP;
+      if (p->advice == PAGE_NORMAL)
+        read_around (p, slot);
+    }
+  else if (p->file != NULL)
+    {
+      page_in_file_cnt++;
+      *class = FAULT_FILE;
+    }
+  else
+    *class = FAULT_ZERO;
+  return true;
+
+ fail:
+  lock_acquire (&frame_lock);
+  frame_unpin (f);
+  frame_free_if_unused (f);
+  lock_release (&frame_lock);
+  if (locked)
+    lock_release (&filesys_lock);
+  return false;
+}
+
+/* Grows the current process's stack to include FAULT_ADDR, where
+   ESP is the process's user stack pointer at the time of the
+   fault, if FAULT_ADDR looks like a stack access: it must be no
+   more than 32 bytes below ESP and within stack_max_pages pages
+   of the top of user memory.  If the stack has been growing one
+   page at a time, also maps pages below FAULT_ADDR ahead of use.
+   Returns true if successful, false if FAULT_ADDR is not a stack
+   access or memory is exhausted. */
+bool
+page_grow_stack (void *fault_addr, const void *esp)
+{
+  struct thread *t = thread_current ();
+  uint8_t *upage = pg_round_down (fault_addr);
+  size_t max_pages = stack_max_pages;
+  uint8_t *limit;
+  size_t i;
+
+  if (max_pages > (size_t) PHYS_BASE / PGSIZE)
+    max_pages = (size_t) PHYS_BASE / PGSIZE;
+  limit = (uint8_t *) PHYS_BASE - max_pages * PGSIZE;
+
+  if (t->pages == NULL || !is_user_vaddr (fault_addr) || upage < limit
+      || (const uint8_t *) fault_addr + 32 < (const uint8_t *) esp)
+    return false;
+
+  if (!page_add_file (t->pages, upage, NULL, 0, 0, true)
+      || !page_in (upage, true, NULL))
+    return false;
+  stack_grow_cnt++;
+
+  /* Growing sequentially, right below the lowest stack page?
+     Then map more pages ahead each time.  Otherwise start
+     over. */
+  if (upage + PGSIZE == t->stack_bottom)
+    t->stack_ahead = (t->stack_ahead == 0 ? 1
+                      : t->stack_ahead < STACK_AHEAD_MAX / 2
+                      ? t->stack_ahead * 2 : STACK_AHEAD_MAX);
+  else
+    t->stack_ahead = 0;
+  if (upage < t->stack_bottom)
+    t->stack_bottom = upage;
+
+  for (i = 1; i <= t->stack_ahead; i++)
+    {
+      uint8_t *ahead = upage - i * PGSIZE;
+
+      if (ahead < limit || page_lookup (t->pages, ahead) != NULL
+          || !page_add_file (t->pages, ahead, NULL, 0, 0, true))
+        break;
+      t->stack_bottom = ahead;
+      if (!page_in (ahead, true, NULL))
+        break;
+      stack_ahead_cnt++;
+    }
+  return true;
+}
+
+/* Handles a write to the present, read-only page that contains
+   FAULT_ADDR in the current process, where the page is one that
+   the process may write but whose frame was shared by fork():
+   gives the process its own copy of the page, or makes the
+   frame writable if no other page uses it any more.  Returns
+   true if successful, false if the fault is a genuine error. */
+bool
+page_copy_on_write (void *fault_addr)
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+  struct frame *old, *new;
+
+  if (t->pages == NULL || !is_user_vaddr (fault_addr))
+    return false;
+
+  p = page_lookup (t->pages, fault_addr);
+  if (p == NULL || !p->writable || p->mapped)
+    return false;
+
+  lock_acquire (&frame_lock);
+  old = p->frame;
+  if (old == NULL || !frame_is_shared (old))
+    {
+      /* If P was evicted since the fault, the access will just
+         fault again and bring it back in, writable. */
+      if (old != NULL)
+        {
+          pagedir_protect_range (t->pagedir, p->upage, 1, true);
+          cow_reuse_cnt++;
+        }
+      lock_release (&frame_lock);
+      return true;
+    }
+  frame_pin (old);
+  lock_release (&frame_lock);
+
+  /* Only this thread can take P out of OLD, and OLD cannot be
+     evicted while it is pinned, so it is safe to copy it without
+     holding the lock. */
+  new = frame_alloc ();
+  if (new != NULL)
+    memcpy (new->kpage, old->kpage, PGSIZE);
+
+  lock_acquire (&frame_lock);
+  frame_unpin (old);
+  if (new != NULL)
+    {
+      /* P's page table already exists, so remapping P cannot
+         fail.  The copy is marked dirty because it need not
+         match P's initial contents any more. */
+      pagedir_clear_page (t->pagedir, p->upage);
+      frame_remove_page (old, p);
+      frame_free_if_unused (old);
+      frame_add_page (new, p);
+      pagedir_set_page (t->pagedir, p->upage, new->kpage, true);
+      pagedir_set_dirty (t->pagedir, p->upage, true);
+      frame_unpin (new);
+      if (old == frame_zero ())
+        zero_copy_cnt++;
+      else
+        cow_copy_cnt++;
+    }
+  lock_release (&frame_lock);
+
+  return new != NULL;
+}
+
+/* Pins the frame that holds the page of the current process
+   that contains user address UADDR and returns it, so that
+   another thread can access the page through the frame's kernel
+   address.  If WRITE is true, the page must be mapped writable,
+   and it is marked dirty, since its contents are about to
+   change behind the page table's back.  Returns a null pointer
+   if the page is not mapped (or not writable) at the moment; the
+   caller may touch it and try again.  Undo with page_unpin(). */
+struct frame *
+page_pin (const void *uaddr, bool write)
+{
+  struct thread *t = thread_current ();
+  struct frame *f = NULL;
+  struct page *p;
+
+  if (t->pages == NULL || !is_user_vaddr (uaddr))
+    return NULL;
+  p = page_lookup (t->pages, uaddr);
+  if (p == NULL)
+    return NULL;
+
+  lock_acquire (&frame_lock);
+  if (p->frame != NULL && !p->read_ahead
+      && pagedir_get_page (t->pagedir, p->upage) == p->frame->kpage
+      && (!write || map_writable (p)))
+    {
+      f = p->frame;
+      frame_pin (f);
+      if (write)
+        pagedir_set_dirty (t->pagedir, p->upage, true);
+    }
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Undoes page_pin(), which returned F.  If the page left F in
+   the meantime, frees F. */
+void
+page_unpin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  frame_unpin (f);
+  if (f != frame_zero ())
+    frame_free_if_unused (f);
+  lock_release (&frame_lock);
+}
+
+/* Returns true if frame F sorts before frame G for writing to
+   swap: by the owner of their first page, then by address. */
+static bool
+cluster_less (struct frame *f, struct frame *g)
+{
+  const struct page *p = list_entry (list_front (&f->pages),
+                                     struct page, frame_elem);
+  const struct page *q = list_entry (list_front (&g->pages),
+                                     struct page, frame_elem);
+  return p->owner != q->owner ? p->owner < q->owner : p->upage < q->upage;
+}
+
+/* Evicts the pages in the CNT frames in FRAMES[]: unmaps them
+   and writes the frames whose contents have been modified to
+   swap, together in consecutive slots if possible.  A frame
+   shared by several pages is written once, and its pages share
+   the slot.  Afterward, each frame that was evicted has no
+   pages.  A frame that cannot be written because swap is full
+   remains mapped, and so does a modified frame of a
+   memory-mapped file, which is queued for page_write_back().
+   The caller must hold frame_lock and is responsible for the
+   frames. */
+void
+page_out_cluster (struct frame *frames[], size_t cnt)
+{
+  struct frame *dirty[SWAP_CLUSTER_MAX];
+  void *kpages[SWAP_CLUSTER_MAX];
+  size_t dirty_cnt = 0;
+  size_t slot;
+  size_t i, j;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (cnt <= SWAP_CLUSTER_MAX);
+
+  /* Unmap each frame first, so that no process can modify it
+     after we have checked whether it is dirty.  Drop the clean
+     ones right away, and set dirty pages of memory-mapped files
+     aside to be written back to their files. */
+  for (i = 0; i < cnt; i++)
+    {
+      struct frame *f = frames[i];
+      struct page *first;
+      bool is_dirty = false;
+      struct list_elem *e;
+
+      ASSERT (f->pin_cnt == 0);
+      for (e = list_begin (&f->pages); e != list_end (&f->pages);
+           e = list_next (e))
+        {
+          struct page *p = list_entry (e, struct page, frame_elem);
+          uint32_t *pd = p->owner->pagedir;
+
+          pagedir_clear_page (pd, p->upage);
+
+          /* A page that was read ahead is unmapped, so its PTE's
+             dirty bit is left over from before and means
+             nothing. */
+          if (!p->read_ahead && pagedir_is_dirty (pd, p->upage))
+            is_dirty = true;
+        }
+
+      first = list_entry (list_front (&f->pages), struct page, frame_elem);
+      if (is_dirty && first->mapped)
+        {
+          remap_frame (f);
+          frame_pin (f);
+          list_push_back (&write_back_queue, &f->write_elem);
+        }
+      else if (is_dirty)
+        {
+          /* Insertion sort, so that a process's adjacent pages
+             land in adjacent slots. */
+          for (j = dirty_cnt++; j > 0 && cluster_less (f, dirty[j - 1]); j--)
+            dirty[j] = dirty[j - 1];
+          dirty[j] = f;
+        }
+      else
+        evict_frame (f, SWAP_NONE);
+    }
+  if (dirty_cnt == 0)
+    return;
+
+  /* Write the dirty frames as one cluster, or one at a time if
+     swap has no run of free slots long enough. */
+  for (i = 0; i < dirty_cnt; i++)
+    kpages[i] = dirty[i]->kpage;
+  slot = swap_out_cluster (kpages, dirty_cnt);
+  for (i = 0; i < dirty_cnt; i++)
+    {
+      struct frame *f = dirty[i];
+      size_t s = slot != SWAP_NONE ? slot + i : swap_out (kpages[i]);
+
+      if (s != SWAP_NONE)
+        evict_frame (f, s);
+      else
+        remap_frame (f);
+    }
+}
+
+/* Writes the frames that page_out_cluster() queued back to the
+   files of their pages, unless their pages were unmapped or
+   written back meanwhile, and releases them.  Returns true if
+   any frames were queued.  The caller must not hold
+   frame_lock. */
+bool
+page_write_back (void)
+{
+  bool queued;
+
+  lock_acquire (&frame_lock);
+  queued = !list_empty (&write_back_queue);
+  lock_release (&frame_lock);
+  if (!queued)
+    return false;
+
+  for (;;)
+    {
+      bool locked = lock_filesys ();
+      struct frame *f = NULL;
+      struct page *p = NULL;
+
+      lock_acquire (&frame_lock);
+      if (!list_empty (&write_back_queue))
+        {
+          f = list_entry (list_pop_front (&write_back_queue),
+                          struct frame, write_elem);
+          p = clean_frame (f);
+        }
+      lock_release (&frame_lock);
+
+      /* F stays pinned, and P cannot be removed while we hold
+         filesys_lock. */
+      if (p != NULL)
+        write_back (p, f);
+      if (f != NULL)
+        {
+          lock_acquire (&frame_lock);
+          frame_unpin (f);
+          frame_free_if_unused (f);
+          lock_release (&frame_lock);
+        }
+      if (locked)
+        lock_release (&filesys_lock);
+      if (f == NULL)
+        return true;
+    }
+}
+
+/* Moves every page in frame FROM into frame TO, if the two hold
+   the same data, mapping them read-only so that a write copies
+   the page again, and returns true.  FROM is left without pages
+   for the caller to free.  If the frames differ, returns false
+   and leaves the pages where they are, write-protected; a write
+   fault makes them writable again.  The caller must hold
+   frame_lock, and neither frame may be pinned. */
+bool
+page_merge (struct frame *from, struct frame *to)
+{
+  struct list_elem *e;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+  ASSERT (from != to);
+
+  /* Write-protect both frames first, so that neither can change
+     between the comparison and the merge. */
+  for (e = list_begin (&from->pages); e != list_end (&from->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      pagedir_protect_range (p->owner->pagedir, p->upage, 1, false);
+    }
+  for (e = list_begin (&to->pages); e != list_end (&to->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      pagedir_protect_range (p->owner->pagedir, p->upage, 1, false);
+    }
+  if (memcmp (from->kpage, to->kpage, PGSIZE))
+    return false;
+
+  /* Each page keeps its dirty bit, as in page_table_copy(). */
+  while (!list_empty (&from->pages))
+    {
+      struct page *p = list_entry (list_front (&from->pages),
+                                   struct page, frame_elem);
+      uint32_t *pd = p->owner->pagedir;
+      bool dirty = pagedir_is_dirty (pd, p->upage);
+
+      pagedir_clear_page (pd, p->upage);
+      frame_remove_page (from, p);
+      frame_add_page (to, p);
+      pagedir_set_page (pd, p->upage, to->kpage, false);
+      pagedir_set_dirty (pd, p->upage, dirty);
+    }
+  return true;
+}
+
+/* Prints paging statistics. */
+void
+page_print_stats (void)
+{
+  printf ("Paging: %lld pages loaded on demand, %lld from files, "
+          "%lld from swap, %lld clean pages dropped\n",
+          page_in_cnt, page_in_file_cnt, page_in_swap_cnt, page_drop_cnt);
+  printf ("Paging: %lld pages read around faults, %lld used, %lld unused\n",
+          read_ahead_cnt, read_ahead_hit_cnt, read_ahead_miss_cnt);
+  printf ("Paging: %lld frames shared by fork, %lld pages copied on write, "
+          "%lld reused in place\n",
+          fork_share_cnt, cow_copy_cnt, cow_reuse_cnt);
+  printf ("Paging: %lld file pages found shared in memory, "
+          "%lld mapped pages written back\n",
+          file_share_cnt, write_back_cnt);
+  printf ("Paging: %lld zero-fill reads mapped to the zero frame, "
+          "%lld of them later written, %zu pages mapped to it now\n",
+          zero_map_cnt, zero_copy_cnt, frame_zero_cnt ());
+  printf ("Paging: %lld stack growth faults, %lld stack pages mapped ahead\n",
+          stack_grow_cnt, stack_ahead_cnt);
+  printf ("Paging: %lld pages read ahead on advice, %lld evicted early "
+          "behind sequential faults, %lld discarded on advice\n",
+          prefetch_cnt, deactivate_cnt, discard_cnt);
+}
+
+/* Creates a page as described for page_add_file() and adds it
+   to PAGES.  Returns the new page, or a null pointer on
+   failure. */
+static struct page *
+add_page (struct hash *pages, void *upage, struct file *file,
+          off_t ofs, uint32_t read_bytes, bool writable)
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (read_bytes <= PGSIZE);
+  ASSERT (read_bytes == 0 || file != NULL);
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+
+  p->owner = thread_current ();
+  p->upage = upage;
+  p->writable = writable;
+  p->frame = NULL;
+  p->swap_slot = SWAP_NONE;
+  p->read_ahead = false;
+  p->mapped = false;
+  p->advice = PAGE_NORMAL;
+  p->file = read_bytes > 0 ? file : NULL;
+  p->file_ofs = ofs;
+  p->read_bytes = read_bytes;
+
+  if (hash_insert (pages, &p->hash_elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Returns true if P is a page of a file that every process that
+   maps it shares, rather than a private copy: a page of a
+   memory-mapped file, or a read-only page of an executable. */
+static bool
+shares_file (const struct page *p)
+{
+  return p->mapped || (p->file != NULL && !p->writable);
+}
+
+/* Returns true if P, which must have a frame, may be mapped
+   writable.  A frame that fork() shares stays read-only until
+   copy-on-write gives each process a copy of its own. */
+static bool
+map_writable (struct page *p)
+{
+  return p->writable && (shares_file (p) || !frame_is_shared (p->frame));
+}
+
+/* Acquires filesys_lock for reading or writing a page's file,
+   unless the current thread already holds it, as it does when a
+   system call faults.  Returns true if it acquired the lock, in
+   which case the caller must release it. */
+static bool
+lock_filesys (void)
+{
+  if (lock_held_by_current_thread (&filesys_lock))
+    return false;
+  lock_acquire (&filesys_lock);
+  return true;
+}
+
+/* If P, which belongs to the current thread, is a page of a
+   memory-mapped file that was modified, writes it back to its
+   file and marks it clean.  The caller must hold filesys_lock
+   if P is such a page, and must not hold frame_lock. */
+static void
+flush_page (struct page *p)
+{
+  uint32_t *pd = p->owner->pagedir;
+  struct frame *f = NULL;
+
+  if (!p->mapped)
+    return;
+
+  lock_acquire (&frame_lock);
+  if (p->frame != NULL && !p->read_ahead && pagedir_is_dirty (pd, p->upage))
+    {
+      f = p->frame;
+      frame_pin (f);
+      pagedir_set_dirty (pd, p->upage, false);
+    }
+  lock_release (&frame_lock);
+
+  if (f != NULL)
+    {
+      write_back (p, f);
+      lock_acquire (&frame_lock);
+      frame_unpin (f);
+      lock_release (&frame_lock);
+    }
+}
+
+/* Clears the dirty bits of the pages in F, a frame of a
+   memory-mapped file.  Returns one of its pages if any of them
+   was dirty, so that the caller can write F back to the page's
+   file, or a null pointer otherwise.  The caller must hold
+   frame_lock. */
+static struct page *
+clean_frame (struct frame *f)
+{
+  struct page *dirty = NULL;
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->owner->pagedir;
+
+      if (!p->read_ahead && pagedir_is_dirty (pd, p->upage))
+        {
+          pagedir_set_dirty (pd, p->upage, false);
+          if (p->mapped)
+            dirty = p;
+        }
+    }
+  return dirty;
+}
+
+/* Maps the pages in frame F again, which page_out_cluster()
+   unmapped but could not evict, and marks them dirty.  Pages
+   that were read ahead stay unmapped.  The caller must hold
+   frame_lock. */
+static void
+remap_frame (struct frame *f)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      struct page *p = list_entry (e, struct page, frame_elem);
+      uint32_t *pd = p->owner->pagedir;
+
+      if (p->read_ahead)
+        continue;
+      pagedir_set_page (pd, p->upage, f->kpage, map_writable (p));
+      pagedir_set_dirty (pd, p->upage, true);
+    }
+}
+
+/* Writes P, a page of a memory-mapped file, from frame F back to
+   its file.  The caller must hold filesys_lock, must not hold
+   frame_lock, and must keep F pinned. */
+static void
+write_back (struct page *p, struct frame *f)
+{
+  ASSERT (p->mapped);
+  ASSERT (lock_held_by_current_thread (&filesys_lock));
+  ASSERT (!lock_held_by_current_thread (&frame_lock));
+
+  file_write_at (p->file, f->kpage, p->read_bytes, p->file_ofs);
+  write_back_cnt++;
+}
+
+/* Removes every page from frame F, which the caller has already
+   unmapped from all of them.  If SLOT is not SWAP_NONE, F's
+   contents were written to swap slot SLOT, which then belongs to
+   the first page; the others take references of their own.  The
+   caller must hold frame_lock. */
+static void
+evict_frame (struct frame *f, size_t slot)
+{
+  bool first = true;
+
+  while (!list_empty (&f->pages))
+    {
+      struct page *p = list_entry (list_front (&f->pages),
+                                   struct page, frame_elem);
+      frame_remove_page (f, p);
+      if (slot != SWAP_NONE)
+        {
+          ASSERT (p->swap_slot == SWAP_NONE);
+          if (!first)
+            swap_dup (slot);
+          p->swap_slot = slot;
+          first = false;
+        }
+      else
+        {
+          if (p->read_ahead)
+            {
+              p->read_ahead = false;
+              read_ahead_miss_cnt++;
+            }
+          page_drop_cnt++;
+        }
+    }
+}
+
+/* Maps page P, which belongs to the current thread, into its
+   frame, read-only if fork() shared the frame.  If P has a swap
+   slot, frees it and marks P dirty, so that P is written out
+   again if it is evicted.  Returns true if successful, false on
+   failure. */
+static bool
+map_page (struct page *p)
+{
+  uint32_t *pd = thread_current ()->pagedir;
+
+  if (!pagedir_set_page (pd, p->upage, p->frame->kpage, map_writable (p)))
+    return false;
+  if (p->swap_slot != SWAP_NONE)
+    {
+      swap_free (p->swap_slot);
+      p->swap_slot = SWAP_NONE;
+      pagedir_set_dirty (pd, p->upage, true);
+    }
+  return true;
+}
+
+/* Fills KPAGE with the contents of page P: from its swap slot,
+   if it has one, or else from its initial contents.  Returns
+   true if successful, false if reading its file fails.  The
+   caller must hold filesys_lock if the page is read from its
+   file, and must not hold frame_lock. */
+static bool
+load_page (struct page *p, void *kpage)
+{
+  if (p->swap_slot != SWAP_NONE)
+    swap_read (p->swap_slot, kpage);
+  else
+    {
+      if (p->file != NULL
+          && file_read_at (p->file, kpage, p->read_bytes, p->file_ofs)
+             != (off_t) p->read_bytes)
+        return false;
+      memset ((uint8_t *) kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+    }
+  return true;
+}
+
+/* Called after a fault on page P of the current process, which
+   the process expects to access sequentially: reads in the
+   pages that follow P, up to SEQ_AHEAD of them, and has the
+   clock evict the page SEQ_BEHIND pages before P first, unless
+   it is used again before then. */
+static void
+sequential_fault (struct page *p)
+{
+  struct thread *t = thread_current ();
+  uint8_t *upage = p->upage;
+  size_t i;
+
+  if ((uintptr_t) upage >= SEQ_BEHIND * PGSIZE)
+    {
+      struct page *q = page_lookup (t->pages, upage - SEQ_BEHIND * PGSIZE);
+      if (q != NULL && q->advice == PAGE_SEQUENTIAL)
+        {
+          lock_acquire (&frame_lock);
+          if (q->frame != NULL && !q->read_ahead
+              && !frame_is_shared (q->frame))
+            {
+              frame_deactivate (q->frame);
+              deactivate_cnt++;
+            }
+          lock_release (&frame_lock);
+        }
+    }
+
+  for (i = 1; i <= SEQ_AHEAD; i++)
+    {
+      uint8_t *ahead = upage + i * PGSIZE;
+      struct page *q;
+
+      if (!is_user_vaddr (ahead))
+        break;
+      q = page_lookup (t->pages, ahead);
+      if (q == NULL || q->advice != PAGE_SEQUENTIAL || !prefetch_page (q))
+        break;
+    }
+}
+
+/* Reads page P of the current process into memory without
+   mapping it, as for read-around, unless it is in memory already
+   or holds only zeros, which are cheap to fault in.  Uses only
+   free frames.  Returns false if none is available or reading P
+   fails, true otherwise. */
+static bool
+prefetch_page (struct page *p)
+{
+  struct frame *f;
+  bool locked;
+
+  if (p->frame != NULL || (p->file == NULL && p->swap_slot == SWAP_NONE))
+    return true;
+
+  lock_acquire (&frame_lock);
+  if (shares_file (p))
+    {
+      f = frame_lookup_file (file_get_inode (p->file), p->file_ofs,
+                             p->read_bytes);
+      if (f != NULL)
+        {
+          frame_add_page (f, p);
+          p->read_ahead = true;
+          lock_release (&frame_lock);
+          return true;
+        }
+    }
+  lock_release (&frame_lock);
+
+  f = frame_try_alloc ();
+  if (f == NULL)
+    return false;
+  locked = p->swap_slot == SWAP_NONE && lock_filesys ();
+  if (!load_page (p, f->kpage))
+    {
+      lock_acquire (&frame_lock);
+      frame_unpin (f);
+      frame_free (f);
+      lock_release (&frame_lock);
+      if (locked)
+        lock_release (&filesys_lock);
+      return false;
+    }
+
+  lock_acquire (&frame_lock);
+  if (shares_file (p))
+    {
+      struct frame *other = frame_insert_file (f, file_get_inode (p->file),
+                                               p->file_ofs, p->read_bytes);
+      if (other != NULL)
+        {
+          frame_unpin (f);
+          frame_free (f);
+          f = other;
+          frame_pin (f);
+        }
+    }
+  frame_add_page (f, p);
+  p->read_ahead = true;
+  frame_unpin (f);
+  lock_release (&frame_lock);
+  if (locked)
+    lock_release (&filesys_lock);
+  prefetch_cnt++;
+  return true;
+}
+
+/* Throws away the contents of page P of the current process,
+   unmapping it and freeing its frame and swap slot, so that its
+   next access starts over from its initial contents.  A page of
+   a memory-mapped file is written back first if it was
+   modified. */
+static void
+discard_page (struct page *p)
+{
+  bool locked = p->mapped && lock_filesys ();
+
+  flush_page (p);
+  lock_acquire (&frame_lock);
+  if (p->frame != NULL || p->swap_slot != SWAP_NONE)
+    discard_cnt++;
+  release_page (p);
+  p->swap_slot = SWAP_NONE;
+  p->read_ahead = false;
+  lock_release (&frame_lock);
+  if (locked)
+    lock_release (&filesys_lock);
+}
+
+/* Reads in, without mapping, the pages that follow page P in
+   both the current process's virtual memory and in swap, where
+   P was in swap slot SLOT, up to a total of swap_cluster pages,
+   for as long as free frames are available. */
+static void
+read_around (struct page *p, size_t slot)
+{
+  struct thread *t = thread_current ();
+  size_t i;
+
+  for (i = 1; i < swap_cluster; i++)
+    {
+      uint8_t *upage = (uint8_t *) p->upage + i * PGSIZE;
+      struct page *q;
+      struct frame *f;
+
+      if (!is_user_vaddr (upage))
+        break;
+      q = page_lookup (t->pages, upage);
+      if (q == NULL || q->frame != NULL || q->swap_slot != slot + i)
+        break;
+
+      f = frame_try_alloc ();
+      if (f == NULL)
+        break;
+      swap_read (q->swap_slot, f->kpage);
+      lock_acquire (&frame_lock);
+      frame_add_page (f, q);
+      q->read_ahead = true;
+      frame_unpin (f);
+      lock_release (&frame_lock);
+      read_ahead_cnt++;
+    }
+}
+
+/* Returns a hash value for the page that E refers to. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if the page that A refers to precedes the one
+   that B refers to. */
+static bool
+page_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED)
+{
+  const struct page *p = hash_entry (a, struct page, hash_elem);
+  const struct page *q = hash_entry (b, struct page, hash_elem);
+  return p->upage < q->upage;
+}
+
+/* Unmaps the page that E refers to, releases its frame and swap
+   slot, and frees the page itself. */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+  ASSERT (!p->mapped);
+  release_page (p);
+  free (p);
+}
+
+/* Unmaps page P and frees its frame (unless another page still
+   uses it) and its swap slot.  A modified page of a
+   memory-mapped file must have been written back with
+   flush_page() first.  The caller must hold frame_lock. */
+static void
+release_page (struct page *p)
+{
+  if (p->frame != NULL)
+    {
+      struct frame *f = p->frame;
+
+      pagedir_clear_page (p->owner->pagedir, p->upage);
+      frame_remove_page (f, p);
+      frame_free_if_unused (f);
+    }
+  if (p->swap_slot != SWAP_NONE)
+    swap_free (p->swap_slot);
+  if (p->read_ahead)
+    read_ahead_miss_cnt++;
+}
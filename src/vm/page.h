@@ -0,0 +1,80 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <faultstat.h>
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+extern size_t stack_max_pages;
+
+/* How a process expects to access a range of pages, as passed to
+   page_advise().  The values match the MADV_* constants of the
+   madvise system call. */
+enum page_advice
+  {
+    PAGE_NORMAL,                /* No particular pattern. */
+    PAGE_SEQUENTIAL,            /* In ascending order, once each. */
+    PAGE_RANDOM,                /* In no predictable order. */
+    PAGE_WILLNEED,              /* Soon: read them in now. */
+    PAGE_DONTNEED               /* Never again: discard them. */
+  };
+
+/* A page of a process's user virtual address space, as recorded
+   in its supplemental page table.
+
+   The page table proper (see userprog/pagedir.c) only knows
+   about pages that are currently in memory.  The supplemental
+   page table also knows where every other page's contents come
+   from, so that they can be brought in when the process
+   touches them: from swap, if the page was swapped out, or else
+   from its initial contents.
+
+   After fork(), a page of the parent and the corresponding page
+   of the child may share a frame or a swap slot until one of
+   them writes to it. */
+struct page
+  {
+    struct hash_elem hash_elem;         /* Element in page table. */
+    struct thread *owner;               /* Process that owns the page. */
+    void *upage;                        /* User virtual address. */
+    bool writable;                      /* Writable by user? */
+    struct frame *frame;                /* Frame, or null if not loaded. */
+    struct list_elem frame_elem;        /* Element in frame's page list. */
+    size_t swap_slot;                   /* Swap slot or SWAP_NONE. */
+    bool read_ahead;                    /* Read ahead, not yet mapped? */
+    bool mapped;                        /* Part of a memory-mapped file? */
+    enum page_advice advice;            /* Expected access pattern. */
+
+    /* Initial contents: READ_BYTES bytes from FILE at FILE_OFS,
+       followed by zeros.  FILE is null for an all-zero page.  A
+       page of a memory-mapped file is written back to FILE. */
+    struct file *file;                  /* Backing file. */
+    off_t file_ofs;                     /* Offset in FILE. */
+    uint32_t read_bytes;                /* Bytes to read from FILE. */
+  };
+
+struct hash *page_table_create (void);
+struct hash *page_table_copy (struct hash *, struct file *old_file,
+                              struct file *new_file);
+void page_table_destroy (struct hash *);
+bool page_add_file (struct hash *, void *upage, struct file *, off_t ofs,
+                    uint32_t read_bytes, bool writable);
+bool page_add_mmap (struct hash *, void *upage, struct file *, off_t ofs,
+                    uint32_t read_bytes);
+void page_remove (struct hash *, const void *upage);
+struct page *page_lookup (struct hash *, const void *upage);
+bool page_in (void *fault_addr, bool write, enum fault_class *);
+bool page_advise (void *addr, size_t length, int advice);
+bool page_grow_stack (void *fault_addr, const void *esp);
+bool page_copy_on_write (void *fault_addr);
+struct frame *page_pin (const void *uaddr, bool write);
+void page_unpin (struct frame *);
+void page_out_cluster (struct frame *[], size_t cnt);
+bool page_write_back (void);
+bool page_merge (struct frame *from, struct frame *to);
+void page_print_stats (void);
+
+#endif /* vm/page.h */
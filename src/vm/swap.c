@@ -0,0 +1,207 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "devices/block.h"
+#include "threads/cpu.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/zswap.h"
+
+/* Swap space.
+
+   The swap device is divided into page-size "slots".  A bitmap
+   records which slots hold a page; it is the only state kept in
+   memory, because pages in swap are tracked by the supplemental
+   page tables of the processes they belong to.
+
+   A slot can be shared by the pages of several processes after
+   fork().  Each slot therefore has a reference count, and it is
+   freed when the last page that refers to it lets go.
+
+   Pages are written out in clusters of up to swap_cluster pages
+   that occupy consecutive slots, and the pager reads clusters
+   back in together, so that swapping costs a few long runs of
+   sectors instead of many scattered single-page transfers.
+
+   Each page is first offered to the compressed pool in
+   vm/zswap.c, which keeps it in memory instead if it compresses
+   well.  The slot is allocated on disk either way, so that the
+   pool can write the page out later without failing. */
+
+/* Number of sectors in a swap slot. */
+#define SECTORS_PER_SLOT (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* The swap device, or null if there is none. */
+static struct block *swap_device;
+
+/* Used slots, the number of references to each used slot, and
+   a lock that protects both. */
+static struct bitmap *used_slots;
+static uint16_t *slot_refs;
+static struct lock swap_lock;
+
+/* Number of pages to write to swap together.
+   Controlled by kernel command-line option "-sc". */
+size_t swap_cluster = 8;
+
+/* Statistics. */
+static long long out_cnt;               /* Pages written to swap. */
+static long long cluster_cnt;           /* Clusters written. */
+static long long in_cnt;                /* Pages read from swap. */
+static long long disk_out_cnt;          /* ...written to disk. */
+static long long disk_in_cnt;           /* ...read from disk. */
+static long long disk_in_cycles;        /* ...total TSC cycles. */
+
+/* Sets up swap space on the block device in the BLOCK_SWAP role,
+   if any. */
+void
+swap_init (void)
+{
+  size_t slot_cnt = 0;
+
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device != NULL)
+    slot_cnt = block_size (swap_device) / SECTORS_PER_SLOT;
+  else
+    printf ("swap: no swap device, pages will not be swapped out\n");
+
+  used_slots = bitmap_create (slot_cnt);
+  slot_refs = calloc (slot_cnt > 0 ? slot_cnt : 1, sizeof *slot_refs);
+  if (used_slots == NULL || slot_refs == NULL)
+    PANIC ("swap: out of memory");
+  lock_init (&swap_lock);
+
+  zswap_init (slot_cnt);
+
+  if (swap_cluster < 1)
+    swap_cluster = 1;
+  else if (swap_cluster > SWAP_CLUSTER_MAX)
+    swap_cluster = SWAP_CLUSTER_MAX;
+}
+
+/* Writes the page at KPAGE to a free swap slot and returns the
+   slot number, or SWAP_NONE if swap space is full. */
+size_t
+swap_out (const void *kpage)
+{
+  void *const kpages[1] = { (void *) kpage };
+  return swap_out_cluster (kpages, 1);
+}
+
+/* Writes the CNT pages at KPAGES[] to CNT consecutive free swap
+   slots and returns the number of the first one, or SWAP_NONE
+   if there is no such run of free slots. */
+size_t
+swap_out_cluster (void *const kpages[], size_t cnt)
+{
+  size_t slot;
+  size_t i;
+
+  ASSERT (cnt > 0);
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip (used_slots, 0, cnt, false);
+  if (slot != BITMAP_ERROR)
+    for (i = 0; i < cnt; i++)
+      slot_refs[slot + i] = 1;
+  lock_release (&swap_lock);
+  if (slot == BITMAP_ERROR)
+    return SWAP_NONE;
+
+  for (i = 0; i < cnt; i++)
+    if (!zswap_store (slot + i, kpages[i]))
+      {
+        swap_write_slot (slot + i, kpages[i]);
+        disk_out_cnt++;
+      }
+  out_cnt += cnt;
+  cluster_cnt++;
+  return slot;
+}
+
+/* Reads the page in swap slot SLOT into KPAGE, leaving the slot
+   allocated. */
+void
+swap_read (size_t slot, void *kpage)
+{
+  size_t i;
+
+  ASSERT (bitmap_test (used_slots, slot));
+  in_cnt++;
+  if (!zswap_load (slot, kpage))
+    {
+      uint64_t start = cpu_rdtsc ();
+      for (i = 0; i < SECTORS_PER_SLOT; i++)
+        block_read (swap_device, slot * SECTORS_PER_SLOT + i,
+                    (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+      disk_in_cnt++;
+      disk_in_cycles += cpu_rdtsc () - start;
+    }
+}
+
+/* Reads the page in swap slot SLOT into KPAGE and drops a
+   reference to the slot. */
+void
+swap_in (size_t slot, void *kpage)
+{
+  swap_read (slot, kpage);
+  swap_free (slot);
+}
+
+/* Adds a reference to swap slot SLOT, which must be in use, for
+   a page that shares it with another. */
+void
+swap_dup (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  ASSERT (slot_refs[slot] < UINT16_MAX);
+  slot_refs[slot]++;
+  lock_release (&swap_lock);
+}
+
+/* Drops a reference to swap slot SLOT without reading it, and
+   frees the slot if that was the last one. */
+void
+swap_free (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (used_slots, slot));
+  ASSERT (slot_refs[slot] > 0);
+  if (--slot_refs[slot] == 0)
+    {
+      zswap_drop (slot);
+      bitmap_reset (used_slots, slot);
+    }
+  lock_release (&swap_lock);
+}
+
+/* Prints swap statistics. */
+void
+swap_print_stats (void)
+{
+  printf ("Swap: %lld pages written in %lld clusters (%lld.%02lld per cluster), "
+          "%lld pages read\n",
+          out_cnt, cluster_cnt,
+          cluster_cnt > 0 ? out_cnt / cluster_cnt : 0,
+          cluster_cnt > 0 ? out_cnt * 100 / cluster_cnt % 100 : 0,
+          in_cnt);
+  printf ("Swap: %lld pages written to disk, %lld read from disk, "
+          "%lld cycles per read on average\n",
+          disk_out_cnt, disk_in_cnt,
+          disk_in_cnt > 0 ? disk_in_cycles / disk_in_cnt : 0);
+}
+
+/* Writes the page at KPAGE to swap slot SLOT on disk, bypassing
+   the compressed pool.  For use by the pool itself. */
+void
+swap_write_slot (size_t slot, const void *kpage)
+{
+  size_t i;
+
+  for (i = 0; i < SECTORS_PER_SLOT; i++)
+    block_write (swap_device, slot * SECTORS_PER_SLOT + i,
+                 (const uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+}
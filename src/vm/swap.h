@@ -0,0 +1,26 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* A swap slot number that denotes "no slot". */
+#define SWAP_NONE SIZE_MAX
+
+/* Maximum number of pages written to or read from swap
+   together. */
+#define SWAP_CLUSTER_MAX 32
+
+extern size_t swap_cluster;
+
+void swap_init (void);
+size_t swap_out (const void *kpage);
+size_t swap_out_cluster (void *const kpages[], size_t cnt);
+void swap_read (size_t slot, void *kpage);
+void swap_in (size_t slot, void *kpage);
+void swap_dup (size_t slot);
+void swap_free (size_t slot);
+void swap_write_slot (size_t slot, const void *kpage);
+void swap_print_stats (void);
+
+#endif /* vm/swap.h */
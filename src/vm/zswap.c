@@ -0,0 +1,335 @@
+#include "vm/zswap.h"
+#include <debug.h>
+#include <list.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/cpu.h"
+#include "threads/malloc.h"
+#include "threads/shrinker.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/lz.h"
+#include "vm/swap.h"
+
+/* Compressed swap pool.
+
+   Writing a page to the swap disk and reading it back costs
+   eight sector transfers each way, which is slow with PIO IDE.
+   So, before a page goes to disk, swap_out_cluster() offers it
+   to this pool, which compresses it with a fast LZ compressor
+   (see vm/lz.c) and keeps the compressed data in kernel memory
+   under the page's swap slot number.  A later swap_read() of the
+   slot just decompresses it.  Pages that do not compress well
+   are written to disk as before.
+
+   The pool is limited to zswap_pool_pages pages of compressed
+   data.  When it grows past that, the least recently used
+   entries are decompressed and written to their slots on disk,
+   so that only the coldest pages pay for disk I/O.  The pool
+   also gives memory back through a shrinker when the kernel
+   pool runs low.
+
+   Compressed data is stored in small fixed-size chunks rather
+   than one block per page, because malloc() rounds blocks
+   larger than half a page up to whole pages, which would waste
+   most of what compression saves. */
+
+/* Size of a chunk, one of malloc()'s block sizes. */
+#define CHUNK_SIZE 256
+
+/* Pages that do not compress to this size or smaller are not
+   worth keeping in the pool. */
+#define MAX_STORED (PGSIZE * 3 / 4)
+
+/* Maximum size of the pool, in pages of compressed data.  0
+   disables the pool.
+   Controlled by kernel command-line option "-zs". */
+size_t zswap_pool_pages = 64;
+
+/* A piece of a compressed page. */
+struct chunk
+  {
+    struct chunk *next;                 /* Next chunk, or null. */
+    uint8_t data[CHUNK_SIZE - sizeof (struct chunk *)];
+  };
+
+/* A compressed page in the pool. */
+struct entry
+  {
+    struct list_elem lru_elem;          /* Element in lru_list. */
+    size_t slot;                        /* Swap slot. */
+    size_t size;                        /* Compressed size in bytes. */
+    size_t chunk_cnt;                   /* Number of chunks. */
+    struct chunk *chunks;               /* Compressed data. */
+  };
+
+/* Pool entries, indexed by swap slot, or null for slots whose
+   contents are on disk (or unused). */
+static struct entry **entries;
+static size_t slot_cnt;
+
+/* Entries, most recently used first. */
+static struct list lru_list;
+static size_t entry_cnt;
+
+/* Bytes of chunks in the pool. */
+static size_t pool_bytes;
+
+/* Protects all of the above and the scratch buffers below. */
+static struct lock zswap_lock;
+
+/* Scratch buffers. */
+static uint16_t hash_table[LZ_HASH_SIZE];
+static uint8_t cbuf[MAX_STORED];
+static uint8_t wbuf[PGSIZE];
+
+/* Statistics. */
+static long long store_cnt;             /* Pages stored. */
+static long long store_bytes;           /* ...compressed size in total. */
+static long long reject_cnt;            /* Pages that did not compress. */
+static long long load_cnt;              /* Pages loaded. */
+static long long load_cycles;           /* ...total TSC cycles. */
+static long long writeback_cnt;         /* Pages written to disk. */
+static size_t peak_bytes;               /* Largest pool size. */
+
+static shrinker_count_func zswap_count;
+static shrinker_scan_func zswap_scan;
+static struct shrinker zswap_shrinker =
+  {"zswap", zswap_count, zswap_scan, 0, {NULL, NULL}};
+
+static void shrink_pool (size_t max_bytes);
+static void write_back (struct entry *);
+static void free_entry (struct entry *);
+
+/* Sets up the pool for a swap device with SLOT_CNT slots. */
+void
+zswap_init (size_t slot_cnt_)
+{
+  slot_cnt = slot_cnt_;
+  list_init (&lru_list);
+  lock_init (&zswap_lock);
+  if (slot_cnt > 0 && zswap_pool_pages > 0)
+    {
+      entries = calloc (slot_cnt, sizeof *entries);
+      if (entries == NULL)
+        PANIC ("zswap: out of memory");
+      shrinker_register (&zswap_shrinker);
+    }
+}
+
+/* Compresses the page at KPAGE into the pool as the contents of
+   swap slot SLOT, which must not be in the pool already.
+   Returns true if successful, false if the pool is disabled,
+   the page does not compress well, or memory is short, in which
+   case the caller should write the page to disk. */
+bool
+zswap_store (size_t slot, const void *kpage)
+{
+  struct entry *e;
+  struct chunk **cp;
+  size_t size, ofs;
+
+  if (entries == NULL)
+    return false;
+  ASSERT (slot < slot_cnt);
+
+  lock_acquire (&zswap_lock);
+  ASSERT (entries[slot] == NULL);
+  size = lz_compress (kpage, PGSIZE, cbuf, sizeof cbuf, hash_table);
+  if (size == 0)
+    {
+      reject_cnt++;
+      lock_release (&zswap_lock);
+      return false;
+    }
+
+  e = malloc (sizeof *e);
+  if (e == NULL)
+    goto fail;
+  e->slot = slot;
+  e->size = size;
+  e->chunk_cnt = 0;
+  e->chunks = NULL;
+  for (cp = &e->chunks, ofs = 0; ofs < size; cp = &(*cp)->next)
+    {
+      size_t n = size - ofs < sizeof (*cp)->data ? size - ofs
+                                                  : sizeof (*cp)->data;
+      *cp = malloc (sizeof **cp);
+      if (*cp == NULL)
+        {
+          free_entry (e);
+          goto fail;
+        }
+      (*cp)->next = NULL;
+      memcpy ((*cp)->data, cbuf + ofs, n);
+      ofs += n;
+      e->chunk_cnt++;
+    }
+
+  entries[slot] = e;
+  list_push_front (&lru_list, &e->lru_elem);
+  entry_cnt++;
+  pool_bytes += e->chunk_cnt * CHUNK_SIZE;
+  if (pool_bytes > peak_bytes)
+    peak_bytes = pool_bytes;
+  store_cnt++;
+  store_bytes += size;
+
+  shrink_pool (zswap_pool_pages * PGSIZE);
+  lock_release (&zswap_lock);
+  return true;
+
+ fail:
+  lock_release (&zswap_lock);
+  return false;
+}
+
+/* If swap slot SLOT is in the pool, decompresses it into KPAGE,
+   leaving it in the pool, and returns true.  Otherwise, returns
+   false, and the caller should read the slot from disk. */
+bool
+zswap_load (size_t slot, void *kpage)
+{
+  uint64_t start = cpu_rdtsc ();
+  struct entry *e;
+  struct chunk *c;
+  size_t ofs;
+
+  if (entries == NULL)
+    return false;
+  ASSERT (slot < slot_cnt);
+
+  lock_acquire (&zswap_lock);
+  e = entries[slot];
+  if (e == NULL)
+    {
+      lock_release (&zswap_lock);
+      return false;
+    }
+
+  for (c = e->chunks, ofs = 0; c != NULL; c = c->next)
+    {
+      size_t n = e->size - ofs < sizeof c->data ? e->size - ofs
+                                                 : sizeof c->data;
+      memcpy (cbuf + ofs, c->data, n);
+      ofs += n;
+    }
+  if (lz_decompress (cbuf, e->size, kpage, PGSIZE) != PGSIZE)
+    PANIC ("zswap: slot %zu is corrupt", slot);
+
+  list_remove (&e->lru_elem);
+  list_push_front (&lru_list, &e->lru_elem);
+  load_cnt++;
+  load_cycles += cpu_rdtsc () - start;
+  lock_release (&zswap_lock);
+  return true;
+}
+
+/* Discards swap slot SLOT from the pool, if it is there. */
+void
+zswap_drop (size_t slot)
+{
+  if (entries == NULL)
+    return;
+
+  lock_acquire (&zswap_lock);
+  if (entries[slot] != NULL)
+    free_entry (entries[slot]);
+  lock_release (&zswap_lock);
+}
+
+/* Prints pool statistics. */
+void
+zswap_print_stats (void)
+{
+  if (entries == NULL)
+    return;
+
+  printf ("Zswap: %lld pages stored, %lld kB compressed to %lld kB, "
+          "%lld incompressible\n",
+          store_cnt, store_cnt * PGSIZE / 1024, store_bytes / 1024,
+          reject_cnt);
+  printf ("Zswap: pool %zu kB now, %zu kB peak, %zu kB limit; "
+          "%lld pages written to disk\n",
+          pool_bytes / 1024, peak_bytes / 1024,
+          zswap_pool_pages * PGSIZE / 1024, writeback_cnt);
+  printf ("Zswap: %lld pages loaded, %lld cycles each on average\n",
+          load_cnt, load_cnt > 0 ? load_cycles / load_cnt : 0);
+}
+
+/* Writes the least recently used entries to disk until the pool
+   holds no more than MAX_BYTES bytes.  The caller must hold
+   zswap_lock. */
+static void
+shrink_pool (size_t max_bytes)
+{
+  while (pool_bytes > max_bytes && !list_empty (&lru_list))
+    write_back (list_entry (list_back (&lru_list), struct entry, lru_elem));
+}
+
+/* Decompresses E to its slot on disk and removes it from the
+   pool.  The caller must hold zswap_lock. */
+static void
+write_back (struct entry *e)
+{
+  struct chunk *c;
+  size_t ofs;
+
+  for (c = e->chunks, ofs = 0; c != NULL; c = c->next)
+    {
+      size_t n = e->size - ofs < sizeof c->data ? e->size - ofs
+                                                 : sizeof c->data;
+      memcpy (cbuf + ofs, c->data, n);
+      ofs += n;
+    }
+  if (lz_decompress (cbuf, e->size, wbuf, PGSIZE) != PGSIZE)
+    PANIC ("zswap: slot %zu is corrupt", e->slot);
+  swap_write_slot (e->slot, wbuf);
+  writeback_cnt++;
+  free_entry (e);
+}
+
+/* Frees E and its chunks and, if it is in the pool, removes it.
+   The caller must hold zswap_lock. */
+static void
+free_entry (struct entry *e)
+{
+  if (entries[e->slot] == e)
+    {
+      entries[e->slot] = NULL;
+      list_remove (&e->lru_elem);
+      entry_cnt--;
+      pool_bytes -= e->chunk_cnt * CHUNK_SIZE;
+    }
+  while (e->chunks != NULL)
+    {
+      struct chunk *c = e->chunks;
+      e->chunks = c->next;
+      free (c);
+    }
+  free (e);
+}
+
+/* Returns the number of entries in the pool. */
+static size_t
+zswap_count (void)
+{
+  return entry_cnt;
+}
+
+/* Writes up to NR of the least recently used entries to disk,
+   freeing their memory.  Returns the number written. */
+static size_t
+zswap_scan (size_t nr)
+{
+  size_t cnt;
+
+  if (lock_held_by_current_thread (&zswap_lock)
+      || !lock_try_acquire (&zswap_lock))
+    return 0;
+  for (cnt = 0; cnt < nr && !list_empty (&lru_list); cnt++)
+    write_back (list_entry (list_back (&lru_list), struct entry, lru_elem));
+  lock_release (&zswap_lock);
+  return cnt;
+}